@@ -1,9 +1,16 @@
 #include "src/game.h"
 #include "src/gameResolver.h"
+#include "src/opening_pairs.h"
+#include "src/simulation.h"
+#include "src/sweep.h"
 #include "src/utils.h"
 #include "src/word_list.h"
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace std;
 int autoGame(const WordList &wordList, int word = -1);
@@ -61,14 +68,273 @@ void autoGamePrint(const WordList &wordList) {
     }
 }
 
+// Play all the games with a grid of scoring parameters.
+void sweepParameters(const WordList &wordList) {
+    vector<ScoringParameters> parameters;
+    for (double entropyMul : {0.8, 0.9, 1.0}) {
+        for (double entropyOffset : {1.3, 1.5, 1.7}) {
+            for (double frequencyMul : {2., 3., 4.}) {
+                ScoringParameters p;
+                p.entropyMul = entropyMul;
+                p.entropyOffset = entropyOffset;
+                p.frequencyMul = frequencyMul;
+                parameters.push_back(p);
+            }
+        }
+    }
+
+    for (const SweepResult &result : sweepScoringParameters(wordList, parameters)) {
+        const ScoringParameters &p = result.parameters;
+        cout << p.entropyMul << " ln(e) + " << p.entropyOffset << ", tanh(frq * "
+             << p.frequencyMul << " + " << p.frequencyOffset << ") + 1 : "
+             << result.averageSteps() << " (max " << result.maxSteps << ", " << result.losses
+             << " perdues)\n";
+    }
+}
+
+// Compare the fast entropy backend with the reference one, on all the words.
+bool checkEntropyBackends(WordList &wordList) {
+    const EntropyBackend backend = wordList.entropyBackend();
+    const auto words = wordList.initialCompatibleWords();
+    vector<double> entropies;
+
+    wordList.setEntropyBackend(EntropyBackend::Scalar);
+    const double setEntropy = wordList.entropy(words);
+    for (int w : words) {
+        entropies.push_back(wordList.entropy(w, words));
+    }
+
+    wordList.setEntropyBackend(EntropyBackend::Fast);
+    double maxDifference = abs(wordList.entropy(words) - setEntropy);
+    for (unsigned int i = 0; i < words.size(); i++) {
+        maxDifference = max(maxDifference, abs(wordList.entropy(words[i], words) - entropies[i]));
+    }
+    wordList.setEntropyBackend(backend);
+
+    const bool valid = maxDifference <= ENTROPY_BACKEND_TOLERANCE;
+    cout << "Écart maximal entre les calculs d'entropie : " << maxDifference << " bits ("
+         << (valid ? "valide" : "invalide") << ").\n";
+    return valid;
+}
+
+// Compare the memory used and the scan speed of the storages of the pattern matrix.
+void benchmarkPatternStorage(const Dictionary &dictionary) {
+    auto clock = chrono::steady_clock();
+    for (PatternStorage storage : {PatternStorage::Raw, PatternStorage::Compressed}) {
+        const WordList wordList(dictionary, "", true, false, storage);
+        const vector<int> words = wordList.initialCompatibleWords();
+        // a possibility set after a first guess
+        Step step;
+        step.word = words[words.size() / 3];
+        step.pattern = wordList.getWordPattern(words[words.size() / 2], step.word);
+        const vector<int> possibleWords = wordList.compatibleWords(words, step);
+
+        cout << (storage == PatternStorage::Raw ? "Brute" : "Compressée") << " : "
+             << wordList.patternMatrix().memoryUsage() / 1'000'000. << " Mo, "
+             << (double)wordList.patternMatrix().memoryUsage() / wordList.numberOfWords() /
+                    wordList.numberOfAnswers()
+             << " octets par motif.\n";
+
+        for (const vector<int> *set : {&words, &possibleWords}) {
+            // at most 1000 guesses, spread over the words
+            const unsigned int stride = max<unsigned int>(words.size() / 1000, 1);
+            double sum = 0;
+            unsigned int guesses = 0;
+            // best of 3 runs
+            chrono::nanoseconds dt = chrono::nanoseconds::max();
+            for (int run = 0; run < 3; run++) {
+                sum = 0;
+                guesses = 0;
+                const auto start = clock.now();
+                for (unsigned int i = 0; i < words.size(); i += stride) {
+                    sum += wordList.entropy(words[i], *set);
+                    guesses++;
+                }
+                dt = min<chrono::nanoseconds>(dt, clock.now() - start);
+            }
+            cout << "  " << set->size() << " possibilités : "
+                 << (double)guesses * set->size() / dt.count() * 1000 << " millions de motifs/s"
+                 << " (entropie moyenne " << sum / guesses << ")\n";
+        }
+    }
+}
+
+// Play the same games with each objective of the guesses.
+void compareObjectives(const Dictionary &dictionary, unsigned int number) {
+    const WordList wordList(dictionary);
+    const vector<int> words = wordList.initialCompatibleWords();
+    const unsigned int stride = max<unsigned int>(words.size() / max(number, 1u), 1);
+    auto clock = chrono::steady_clock();
+
+    const vector<string> names = {"Espérance", "Pire cas", "Mixte"};
+    vector<Objective> objectives(3);
+    objectives[1].type = GuessObjective::WorstCase;
+    objectives[2].type = GuessObjective::Mixed;
+    for (unsigned int k = 0; k < objectives.size(); k++) {
+        GameResolver gameResolver(wordList);
+        gameResolver.setObjective(objectives[k]);
+        Game game(wordList, 20);
+        unsigned int games = 0, totalSteps = 0, maxSteps = 0;
+        const auto start = clock.now();
+        for (unsigned int i = 0; i < words.size(); i += stride) {
+            game.reset(words[i]);
+            gameResolver.reset();
+            while (game.gameStatus() <= 0) {
+                gameResolver.update(game.update(gameResolver.bestChoice().word));
+            }
+            games++;
+            totalSteps += game.numberSteps();
+            maxSteps = max(maxSteps, game.numberSteps());
+        }
+        const chrono::nanoseconds dt = clock.now() - start;
+        cout << names[k] << " : score moyen " << (double)totalSteps / games << ", maximum "
+             << maxSteps << " (" << games << " parties, " << dt.count() / 1'000'000 << " ms)\n";
+    }
+}
+
+void printSimulationResult(const SimulationResult &result) {
+    cout << result.games << " parties, score moyen: " << result.averageSteps() << " ("
+         << result.losses << " perdues).\n";
+    for (unsigned int steps = 1; steps < result.histogram.size(); steps++) {
+        if (result.histogram[steps])
+            cout << steps << "\t" << result.histogram[steps] << "\n";
+    }
+    if (!result.isComplete())
+        cout << "Seulement " << result.shards.size() << "/" << result.spec.shardCount
+             << " parties de la simulation.\n";
+}
+
+// The dictionary named by an argument of the commands, false (with a message) if there is none.
+bool parseDictionary(const string &name, Dictionary &dictionary) {
+    if (Dictionary::fromName(name, dictionary))
+        return true;
+    cerr << "Dictionnaire inconnu \"" << name << "\" : un nombre de lettres de "
+         << Dictionary::MIN_FRENCH_WORD_LENGTH << " à " << Dictionary::MAX_WORD_LENGTH
+         << " ou en pour les mots anglais.\n";
+    return false;
+}
+
+// A number argument of the commands, false (with a message) if it isn't a number of this type.
+template <typename Number> bool parseNumber(const string &argument, Number &value) {
+    istringstream values(argument);
+    Number number;
+    // the unsigned types would read a negative number modulo their size
+    if (argument.empty() || argument[0] == '-' || !(values >> number) || !values.eof()) {
+        cerr << "Nombre invalide \"" << argument << "\".\n";
+        return false;
+    }
+    value = number;
+    return true;
+}
+
+// Commands to run without the terminal interface, <letters> is the number of letters of the french
+// words or "en" for the english words:
+// simulate <letters> <output file> [seed] [shard] [number of shards] [number of answers]
+// merge <output file> <results files...>
+// montecarlo <letters> [seed] [half width of the confidence interval]
+// matrix <letters>: benchmark of the storages of the pattern matrix
+// objectives <letters> [number of answers]: games played with each objective of the guesses
+// pairs <letters> <output file> [number of pairs] [checkpoint file]: best two words openings
+int runCommand(int argc, const char **argv) {
+    const string command = argv[1];
+    // all the commands but merge start with the dictionary
+    Dictionary dictionary;
+    if (command != "merge" && argc >= 3 && !parseDictionary(argv[2], dictionary))
+        return 1;
+    // the arguments are read by position, a command with too many arguments (or a shard without
+    // the number of shards) isn't run
+    if (command == "simulate" && argc >= 4 && argc <= 8 && argc != 6) {
+        SimulationSpec spec;
+        if ((argc > 4 && !parseNumber(argv[4], spec.seed)) ||
+            (argc > 6 &&
+             (!parseNumber(argv[5], spec.shard) || !parseNumber(argv[6], spec.shardCount))) ||
+            (argc > 7 && !parseNumber(argv[7], spec.sampleSize)))
+            return 1;
+        if (spec.shard >= spec.shardCount) {
+            cerr << "La partie doit être comprise entre 0 et le nombre de parties - 1.\n";
+            return 1;
+        }
+        WordList wordList(dictionary);
+
+        const SimulationResult result = simulate(wordList, spec);
+        printSimulationResult(result);
+        return saveSimulationResult(argv[3], result) ? 0 : 1;
+    } else if (command == "merge" && argc >= 4) {
+        SimulationResult result;
+        if (!mergeSimulationResults(vector<string>(argv + 3, argv + argc), result))
+            return 1;
+        printSimulationResult(result);
+        return saveSimulationResult(argv[2], result) ? 0 : 1;
+    } else if (command == "montecarlo" && argc >= 3 && argc <= 5) {
+        WordList wordList(dictionary);
+        MonteCarloSpec spec;
+        if ((argc > 3 && !parseNumber(argv[3], spec.seed)) ||
+            (argc > 4 && !parseNumber(argv[4], spec.maxHalfWidth)))
+            return 1;
+
+        const SimulationResult result = monteCarlo(wordList, spec);
+        printSimulationResult(result);
+        cout << "Intervalle de confiance à 95% : +/- " << result.confidenceHalfWidth(spec.z)
+             << "\n";
+        return 0;
+    } else if (command == "matrix" && argc == 3) {
+        benchmarkPatternStorage(dictionary);
+        return 0;
+    } else if (command == "objectives" && argc >= 3 && argc <= 4) {
+        unsigned int number = 500;
+        if (argc > 3 && !parseNumber(argv[3], number))
+            return 1;
+        compareObjectives(dictionary, number);
+        return 0;
+    } else if (command == "pairs" && argc >= 4 && argc <= 6) {
+        WordList wordList(dictionary);
+        OpeningPairsSpec spec;
+        if (argc > 4 && !parseNumber(argv[4], spec.number))
+            return 1;
+        if (argc > 5)
+            spec.checkpointPath = argv[5];
+        spec.onCheckpoint = [](unsigned int done, unsigned int total) {
+            cout << done << "/" << total << " premiers mots." << endl;
+        };
+
+        const auto start = chrono::steady_clock::now();
+        OpeningPairsStats stats;
+        const vector<OpeningPair> pairs = searchOpeningPairs(wordList, spec, &stats);
+        cout << stats.evaluated << " paires évaluées (" << stats.stopped << " interrompues) en "
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s.\n";
+        for (unsigned int i = 0; i < min((unsigned int)pairs.size(), 10u); i++) {
+            cout << wordList.getWord(pairs[i].first).word << " "
+                 << wordList.getWord(pairs[i].second).word << " (" << pairs[i].entropy
+                 << " bits, " << pairs[i].sets << " ensembles).\n";
+        }
+        return saveOpeningPairs(argv[3], wordList, pairs) ? 0 : 1;
+    }
+
+    cerr << "Usage:\n"
+         << argv[0] << " simulate <lettres> <fichier> [graine] [partie] [parties] [mots]\n"
+         << argv[0] << " merge <fichier> <fichiers des parties...>\n"
+         << argv[0] << " montecarlo <lettres> [graine] [précision]\n"
+         << argv[0] << " matrix <lettres>\n"
+         << argv[0] << " objectives <lettres> [mots]\n"
+         << argv[0] << " pairs <lettres> <fichier> [paires] [fichier de reprise]\n";
+    return 1;
+}
+
 int main(int argc, const char **argv) {
-    int nbLetters;
+    if (argc > 1)
+        return runCommand(argc, argv);
+
+    string name;
+    Dictionary dictionary;
+    do {
+        cout << "Nombre de lettres (en pour les mots anglais) : ";
+        if (!(cin >> name))
+            return 1;
+    } while (!parseDictionary(name, dictionary));
     string mask;
-    cout << "Nombre de lettres : ";
-    cin >> nbLetters;
     cout << "Masque : ";
     cin >> mask;
-    WordList wordList(nbLetters, mask);
+    WordList wordList(dictionary, mask);
 
     // double av = 0;
 
@@ -91,7 +357,9 @@ int main(int argc, const char **argv) {
     while (true) {
         gameResolver.play();
     }
+    // checkEntropyBackends(wordList);
     // doAllGames(wordList);
+    // sweepParameters(wordList);
     // int total = 0;
     // const int IT = 100;
     // for (int i = 0; i < IT; i++) {
@@ -0,0 +1,58 @@
+#include "alias_table.h"
+#include "utils.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+using namespace std;
+
+AliasTable::AliasTable(const vector<double> &weights)
+    : m_probabilities(weights.size(), 1), m_aliases(weights.size()) {
+    const unsigned int size = weights.size();
+    const double total = accumulate(weights.begin(), weights.end(), 0.);
+    iota(m_aliases.begin(), m_aliases.end(), 0);
+    if (size <= 0 || total <= 0)
+        return;
+
+    // scaled so that the mean is 1
+    vector<double> scaled(size);
+    vector<unsigned int> small, large;
+    for (unsigned int i = 0; i < size; i++) {
+        scaled[i] = max(weights[i], 0.) * size / total;
+        if (scaled[i] < 1)
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+
+    // each small column is filled with a large one
+    while (!small.empty() && !large.empty()) {
+        const unsigned int s = small.back();
+        const unsigned int l = large.back();
+        small.pop_back();
+        m_probabilities[s] = scaled[s];
+        m_aliases[s] = l;
+        scaled[l] -= 1 - scaled[s];
+        if (scaled[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // the remaining columns are full (up to rounding errors)
+    for (unsigned int i : small) {
+        m_probabilities[i] = 1;
+    }
+    for (unsigned int i : large) {
+        m_probabilities[i] = 1;
+    }
+}
+
+unsigned int AliasTable::sample(mt19937_64 &generator) const {
+    d_assert(size() > 0);
+    const unsigned int column = randomInt(generator, 0, m_probabilities.size());
+    // 53 random bits, the same on every platform
+    const double coin = (generator() >> 11) * 0x1.0p-53;
+    return coin < m_probabilities[column] ? column : m_aliases[column];
+}
+
+unsigned int AliasTable::size() const { return m_probabilities.size(); }
@@ -0,0 +1,23 @@
+#ifndef SRC_ALIAS_TABLE_H_
+#define SRC_ALIAS_TABLE_H_
+
+#include <random>
+#include <vector>
+
+/**
+ * @brief Draws indices with probabilities proportional to weights in O(1) (Vose's alias method).
+ */
+class AliasTable {
+  public:
+    AliasTable(const std::vector<double> &weights = {});
+
+    unsigned int sample(std::mt19937_64 &generator) const;
+    unsigned int size() const;
+
+  private:
+    // [i] = probability to keep i, otherwise m_aliases[i] is drawn
+    std::vector<double> m_probabilities;
+    std::vector<unsigned int> m_aliases;
+};
+
+#endif // !SRC_ALIAS_TABLE_H_
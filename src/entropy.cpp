@@ -0,0 +1,62 @@
+#include "entropy.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+using namespace std;
+
+vector<double> nLogNTable(unsigned int size) {
+    vector<double> table(size + 1);
+    table[0] = 0;
+    for (unsigned int n = 1; n <= size; n++) {
+        table[n] = n * log2((double)n);
+    }
+    return table;
+}
+
+// Sum with independent accumulators, so that it doesn't wait on each addition.
+static double sum(const double *values, int size) {
+    double sums[4] = {0, 0, 0, 0};
+    int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        sums[0] += values[i];
+        sums[1] += values[i + 1];
+        sums[2] += values[i + 2];
+        sums[3] += values[i + 3];
+    }
+    for (; i < size; i++) {
+        sums[0] += values[i];
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+// Replaces each weight w by w * log2(w) (0 if w <= 0).
+// There is no dependency between iterations so the loop is vectorized by the compiler.
+static void wLog2W(double *values, int size) {
+    for (int i = 0; i < size; i++) {
+        const double weight = values[i];
+        // fastLog2 returns a finite value (meaningless) for non positive weights, it is masked
+        // with the bits (a floating point comparison would introduce a branch)
+        uint64_t bits;
+        memcpy(&bits, &weight, sizeof(bits));
+        const uint64_t keepMask = 0 - (((bits - 1) >> 63) ^ 1);
+
+        const double value = weight * fastLog2(weight);
+        memcpy(&bits, &value, sizeof(bits));
+        bits &= keepMask;
+        memcpy(&values[i], &bits, sizeof(bits));
+    }
+}
+
+double weightsEntropy(vector<double> &weights) {
+    const int size = weights.size();
+    double *w = weights.data();
+
+    const double totalWeight = sum(w, size);
+    if (totalWeight <= 0)
+        return 0;
+
+    // entropy = log2(total) - sum(w * log2(w)) / total
+    wLog2W(w, size);
+    return log2(totalWeight) - sum(w, size) / totalWeight;
+}
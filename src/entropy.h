@@ -0,0 +1,78 @@
+#ifndef SRC_ENTROPY_H_
+#define SRC_ENTROPY_H_
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+enum class EntropyBackend {
+    // Reference implementation: one log() per bucket or per word.
+    Scalar,
+    // Table of n·log2(n) for bucket counts and vectorized polynomial log2 for weights.
+    Fast,
+};
+
+#define DEFAULT_ENTROPY_BACKEND EntropyBackend::Fast
+
+// Maximal difference (in bits) allowed between the results of the two backends.
+constexpr double ENTROPY_BACKEND_TOLERANCE = 1e-9;
+
+/**
+ * @brief Branch free approximation of log2, written so that loops calling it can be vectorized.
+ *
+ * The mantissa is brought back to [sqrt(2)/2, sqrt(2)) and ln(m) = 2 atanh((m - 1) / (m + 1)) is
+ * evaluated with its series up to the 13th power (absolute error below 1e-12).
+ *
+ * @param x a strictly positive and normal number
+ * @return log2(x)
+ */
+inline double fastLog2(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    // Everything is done on the bits so that the compiler doesn't need branches (the floating
+    // point operations could trap) and vectorizes the loops calling this function.
+    // The mantissa is compared to the one of sqrt(2) with a subtraction (SSE2 has no 64 bits
+    // comparison).
+    const uint64_t mantissa = bits & 0x000fffffffffffff;
+    const uint64_t isBig = (0x0006a09e667f3bcd - mantissa) >> 63;
+
+    // exponent as a double, without any int64 -> double conversion
+    const uint64_t exponentBits = ((bits >> 52) + isBig) | 0x4330000000000000;
+    double exponent;
+    std::memcpy(&exponent, &exponentBits, sizeof(exponent));
+    exponent -= 4503599627370496. + 1023.;
+
+    // mantissa in [sqrt(2)/2, sqrt(2))
+    const uint64_t mBits = mantissa | (0x3ff0000000000000 - (isBig << 52));
+    double m;
+    std::memcpy(&m, &mBits, sizeof(m));
+
+    const double s = (m - 1) / (m + 1);
+    const double s2 = s * s;
+    const double ln =
+        s * (2. + s2 * (2. / 3 +
+                        s2 * (2. / 5 +
+                              s2 * (2. / 7 + s2 * (2. / 9 + s2 * (2. / 11 + s2 * (2. / 13)))))));
+    return exponent + ln * 1.4426950408889634;
+}
+
+/**
+ * @brief Table of n·log2(n), used to compute the entropy of bucket counts without any log.
+ *
+ * @param size the biggest count needed
+ * @return the table with the values for n from 0 to size (0·log2(0) = 0)
+ */
+std::vector<double> nLogNTable(unsigned int size);
+
+/**
+ * @brief Entropy (in bits) of a distribution given by weights.
+ *
+ * The buffer is used as a scratch space and its content is lost.
+ *
+ * @param weights the weights of each element, non normalised, zero or negative are ignored
+ * @return -sum(p * log2(p))
+ */
+double weightsEntropy(std::vector<double> &weights);
+
+#endif // !SRC_ENTROPY_H_
@@ -7,8 +7,8 @@
 
 using namespace std;
 
-Game::Game(const WordList &wordList, int maxSteps)
-    : m_wordList(wordList), m_maxSteps(maxSteps), m_steps() {
+Game::Game(const WordList &wordList, int maxSteps, uint64_t seed)
+    : m_wordList(wordList), m_maxSteps(maxSteps), m_steps(), m_generator(seed) {
     reset();
 };
 
@@ -18,14 +18,8 @@ void Game::reset(int w) {
     if (w >= 0) {
         m_word = w;
     } else {
-        Word word;
-        int i = 0;
-        while (i++ < 5000) {
-            m_word = randomInt(0, m_wordList.numberOfWords());
-            word = m_wordList.getWord(m_word);
-            if (word.frq > 10)
-                break;
-        }
+        // the most frequent words are more likely to be chosen
+        m_word = m_wordList.randomAnswer(m_generator);
     }
 #if DEBUG
     cout << "Current word: " << m_word << "\n";
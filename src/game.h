@@ -2,12 +2,14 @@
 #define SRC_GAME_H_
 
 #include "word_list.h"
+#include <cstdint>
+#include <random>
 #include <string>
 #include <vector>
 
 class Game {
   public:
-    Game(const WordList &wordList, int maxSteps = -1);
+    Game(const WordList &wordList, int maxSteps = -1, uint64_t seed = std::random_device{}());
 
     void reset(int word = -1);
     // return the pattern that gives the word
@@ -25,6 +27,8 @@ class Game {
   private:
     std::vector<Step> m_steps;
     int m_word;
+    // the random words only depend on the seed
+    std::mt19937_64 m_generator;
 };
 
 class TerminalGame : private Game {
@@ -3,15 +3,18 @@
 #include "utils.h"
 #include "word_list.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iterator>
+#include <list>
 #include <stdexcept>
 #include <vector>
 
 using namespace std;
 
 GameResolver::GameResolver(const WordList &wordList)
-    : m_wordList(wordList), m_steps(), m_possibilities(wordList.numberOfWords()) {
+    : m_wordList(wordList), m_steps(), m_possibilities(wordList.numberOfWords()),
+      m_gatheredPatterns(), m_objective() {
     reset();
 }
 
@@ -21,13 +24,18 @@ void GameResolver::reset() {
 }
 
 void GameResolver::invalidatePossibilities() {
-    m_possibilities.clear();
-    // const int size = m_wordList.numberOfWords();
-    vector<int> compatibleWords = m_wordList.initialCompatibleWords();
-    for (int i : compatibleWords) {
-        if (m_wordList.isWordCompatible(i, m_steps))
-            m_possibilities.push_back(i);
-    }
+    m_possibilities = m_wordList.compatibleWords(m_wordList.initialCompatibleWords(), m_steps);
+    m_gatheredPatterns.reset();
+    updateGatheredPatterns();
+}
+
+void GameResolver::updateGatheredPatterns() {
+    // The next possibilities are some of the current ones, so the block is kept until the end of
+    // the game: the rows gathered at a turn are reused by the next ones.
+    if (m_gatheredPatterns == nullptr && m_possibilities.size() <= GATHERED_POSSIBILITIES &&
+        m_wordList.canGatherPatterns())
+        m_gatheredPatterns.reset(
+            new GatheredPatterns(m_wordList.patternMatrix(), m_possibilities));
 }
 
 void GameResolver::update(int word, int pattern) {
@@ -39,6 +47,7 @@ void GameResolver::update(int word, int pattern) {
 void GameResolver::update(Step step) {
     m_steps.push_back(step);
     m_possibilities = m_wordList.compatibleWords(m_possibilities, step);
+    updateGatheredPatterns();
 }
 
 void GameResolver::cancelSteps(int number) {
@@ -50,29 +59,89 @@ void GameResolver::cancelSteps(int number) {
     invalidatePossibilities();
 }
 
-Result GameResolver::bestChoice() const {
+Result GameResolver::bestChoice() const { return bestChoice(SearchLimits()); }
+
+Result GameResolver::bestChoice(const SearchLimits &limits, SearchStats *stats) const {
     const int size = m_possibilities.size();
     if (size == 1) {
         Result result;
         result.word = m_possibilities.front();
         result.score = 0;
+        if (stats != nullptr) {
+            *stats = SearchStats();
+            stats->candidates = 1;
+        }
         return result;
     } else if (size <= 0) {
         throw runtime_error("Not enough possibilities to choose.");
     }
-    return m_wordList.topWord(m_possibilities);
+
+    // the first guess is only computed once (the saved one minimizes the expected score)
+    const bool isOpening = m_steps.empty() && m_objective.type == GuessObjective::Expected;
+    Result result;
+    if (isOpening && m_wordList.opening(result)) {
+        if (stats != nullptr) {
+            *stats = SearchStats();
+            stats->candidates = size;
+        }
+        return result;
+    }
+
+    SearchLimits objectiveLimits = limits;
+    objectiveLimits.objective = m_objective;
+    SearchStats searchStats;
+    result = m_wordList.topWord(m_possibilities, objectiveLimits, &searchStats,
+                                m_gatheredPatterns.get());
+    if (isOpening && searchStats.complete)
+        m_wordList.rememberOpening(result);
+    if (stats != nullptr)
+        *stats = searchStats;
+    return result;
 }
+list<Result> GameResolver::topChoices(unsigned int number) const {
+    return m_wordList.topWords(m_possibilities, number, nullptr, m_gatheredPatterns.get(),
+                               m_objective);
+}
+
+const Objective &GameResolver::objective() const { return m_objective; }
+void GameResolver::setObjective(const Objective &objective) { m_objective = objective; }
+
 int GameResolver::possibilitiesCount() const { return m_possibilities.size(); }
+const vector<int> &GameResolver::possibilities() const { return m_possibilities; }
 double GameResolver::entropy() const { return m_wordList.entropy(m_possibilities); }
 
-TerminalGameResolver::TerminalGameResolver(const WordList &wordList) : GameResolver(wordList) {}
+TerminalGameResolver::TerminalGameResolver(const WordList &wordList, double maxSearchTime)
+    : GameResolver(wordList), m_maxSearchTime(maxSearchTime) {}
+
+Result TerminalGameResolver::searchBestChoice() const {
+    // The options found are shown as they come when the search takes time.
+    const auto start = chrono::steady_clock::now();
+    const auto showDelay = chrono::milliseconds(200);
+    const int currentNumberSteps = m_steps.size();
+    SearchLimits limits;
+    if (m_maxSearchTime >= 0)
+        limits.deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                                      chrono::duration<double>(m_maxSearchTime));
+    limits.onImprovement = [&](const Result &result) {
+        if (chrono::steady_clock::now() - start >= showDelay)
+            cout << "Option : " << m_wordList.getWord(result.word).word << " ("
+                 << result.score + currentNumberSteps << " coups).\n";
+    };
+
+    SearchStats stats;
+    const Result result = bestChoice(limits, &stats);
+    if (!stats.complete)
+        cout << "Recherche interrompue (" << stats.evaluated << "/" << stats.candidates
+             << " mots évalués).\n";
+    return result;
+}
 
 void TerminalGameResolver::play() {
     reset();
     int possibilities;
     while ((possibilities = m_possibilities.size()) > 1) {
-        Result bestChoice = this->bestChoice();
         cout << "\n" << possibilities << " possibilités (" << entropy() << " bits).\n";
+        Result bestChoice = searchBestChoice();
         cout << "Meilleure option: " << m_wordList.getWord(bestChoice.word).word << " ("
              << bestChoice.score + m_steps.size() << " coups).\n";
         Step step = inputWord("Entrez le mot choisi : ");
@@ -117,11 +186,13 @@ Step TerminalGameResolver::inputWord(const std::string &prompt) {
             const double totalScore = m_wordList.totalScore(m_possibilities);
             const int currentNumberSteps = m_steps.size();
 
-            for (int i = 0; i < numberToShow && i < possibilitiesSize; i++) {
-                const Word word = m_wordList.getWord(m_possibilities[i]);
-                cout << word.word << " ("
-                     << m_wordList.score(m_possibilities[i], m_possibilities) + currentNumberSteps
-                     << " coups - " << word.score / totalScore * 100 << "%)\n";
+            const vector<int> shown(m_possibilities.begin(),
+                                    m_possibilities.begin() + min(numberToShow, possibilitiesSize));
+            for (const Result &result :
+                 m_wordList.scores(shown, m_possibilities, m_gatheredPatterns.get())) {
+                const Word word = m_wordList.getWord(result.word);
+                cout << word.word << " (" << result.score + currentNumberSteps << " coups - "
+                     << word.score / totalScore * 100 << "%)\n";
             }
             int remaining = possibilitiesSize - numberToShow;
             if (remaining > 0) {
@@ -131,7 +202,7 @@ Step TerminalGameResolver::inputWord(const std::string &prompt) {
         } else if (word == "S") {
             cout << "Suggestions :\n";
             const int currentNumberSteps = m_steps.size();
-            list<Result> choices = m_wordList.topWords(m_possibilities);
+            list<Result> choices = topChoices(10);
             for (Result &result : choices) {
                 cout << m_wordList.getWord(result.word).word << " ("
                      << result.score + currentNumberSteps << " coups).\n";
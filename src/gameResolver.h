@@ -2,9 +2,16 @@
 #define SRC_GAMERESOLVER_H_
 
 #include "game.h"
+#include "pattern_matrix.h"
 #include "word_list.h"
+#include <list>
+#include <memory>
 #include <vector>
 
+// The patterns are gathered in a dense block when there are at most this number of possibilities
+// (0 to never gather them).
+#define GATHERED_POSSIBILITIES 1024
+
 class GameResolver {
   public:
     GameResolver(const WordList &wordList);
@@ -13,27 +20,42 @@ class GameResolver {
     void update(int word, int pattern);
     void update(Step step);
     Result bestChoice() const;
+    Result bestChoice(const SearchLimits &limits, SearchStats *stats = nullptr) const;
+    // the best choices, sorted by score
+    std::list<Result> topChoices(unsigned int number = 10) const;
     int possibilitiesCount() const;
+    const std::vector<int> &possibilities() const;
     double entropy() const;
     void cancelSteps(int number = 1);
+    const Objective &objective() const;
+    void setObjective(const Objective &objective);
 
   protected:
     void invalidatePossibilities();
+    void updateGatheredPatterns();
 
     const WordList &m_wordList;
     std::vector<Step> m_steps;
     std::vector<int> m_possibilities;
+    // patterns of the possibilities (or of a previous bigger set), nullptr if there are too many
+    std::unique_ptr<GatheredPatterns> m_gatheredPatterns;
+    // what the choices minimize
+    Objective m_objective;
 };
 
 class TerminalGameResolver : private GameResolver {
   public:
-    TerminalGameResolver(const WordList &wordList);
+    // maxSearchTime: time (in seconds) given to find the best option, no limit if negative
+    TerminalGameResolver(const WordList &wordList, double maxSearchTime = -1);
 
     void play();
     Step inputWord(const std::string &prompt);
     int inputPattern() const;
 
   private:
+    Result searchBestChoice() const;
+
+    const double m_maxSearchTime;
 };
 
 #endif // !SRC_GAMERESOLVER_H_
\ No newline at end of file
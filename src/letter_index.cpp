@@ -0,0 +1,178 @@
+#include "letter_index.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+using namespace std;
+
+WordSet::WordSet(unsigned int size, bool full)
+    : m_size(size), m_blocks((size + 63) / 64, full ? ~uint64_t(0) : 0) {
+    // the bits after the last word stay empty
+    if (full && size % 64)
+        m_blocks.back() = (uint64_t(1) << (size % 64)) - 1;
+}
+
+unsigned int WordSet::size() const { return m_size; }
+
+void WordSet::clear() { fill(m_blocks.begin(), m_blocks.end(), 0); }
+
+WordSet &WordSet::operator&=(const WordSet &set) {
+    d_assert(set.m_size == m_size);
+    for (unsigned int i = 0; i < m_blocks.size(); i++) {
+        m_blocks[i] &= set.m_blocks[i];
+    }
+    return *this;
+}
+
+void WordSet::subtract(const WordSet &set) {
+    d_assert(set.m_size == m_size);
+    for (unsigned int i = 0; i < m_blocks.size(); i++) {
+        m_blocks[i] &= ~set.m_blocks[i];
+    }
+}
+
+vector<int> WordSet::filter(const vector<int> &words) const {
+    vector<int> result;
+    for (int word : words) {
+        if (contains(word))
+            result.push_back(word);
+    }
+    return result;
+}
+
+LetterIndex::LetterIndex()
+    : m_wordLength(0), m_numberWords(0), m_letters(), m_positionWords(), m_countWords() {
+    fill(m_letters, m_letters + 256, -1);
+}
+
+void LetterIndex::reset(unsigned int wordLength, unsigned int numberWords) {
+    m_wordLength = wordLength;
+    m_numberWords = numberWords;
+    fill(m_letters, m_letters + 256, -1);
+    m_positionWords.clear();
+    m_countWords.clear();
+}
+
+void LetterIndex::setWord(unsigned int word, const string &letters) {
+    d_assert(word < m_numberWords && letters.size() == m_wordLength);
+    unsigned int counts[256] = {0};
+    for (unsigned int i = 0; i < m_wordLength; i++) {
+        const unsigned char c = letters[i];
+        if (m_letters[c] < 0) {
+            m_letters[c] = m_positionWords.size() / m_wordLength;
+            m_positionWords.resize(m_positionWords.size() + m_wordLength, WordSet(m_numberWords));
+            m_countWords.resize(m_countWords.size() + m_wordLength, WordSet(m_numberWords));
+        }
+        m_positionWords[m_letters[c] * m_wordLength + i].insert(word);
+        m_countWords[m_letters[c] * m_wordLength + counts[c]++].insert(word);
+    }
+}
+
+int LetterIndex::letterIndex(char letter) const { return m_letters[(unsigned char)letter]; }
+
+const WordSet &LetterIndex::positionWords(int letter, unsigned int position) const {
+    return m_positionWords[letter * m_wordLength + position];
+}
+
+const WordSet &LetterIndex::countWords(int letter, unsigned int count) const {
+    d_assert(1 <= count && count <= m_wordLength);
+    return m_countWords[letter * m_wordLength + count - 1];
+}
+
+WordSet LetterIndex::maskWords(const string &mask) const {
+    WordSet words(m_numberWords, true);
+    if (mask.size() != m_wordLength)
+        return words;
+
+    // [character] = number of times the letter is in the word
+    unsigned int counts[256] = {0};
+    bool hasLowercase[256] = {false};
+    for (unsigned int i = 0; i < m_wordLength; i++) {
+        const char c = mask[i];
+        if ('A' <= c && c <= 'Z') {
+            const int letter = letterIndex(c);
+            if (letter < 0) {
+                words.clear();
+                return words;
+            }
+            words &= positionWords(letter, i);
+            counts[(unsigned char)c]++;
+        } else if ('a' <= c && c <= 'z') {
+            const char upper = toupper(c);
+            counts[(unsigned char)upper]++;
+            hasLowercase[(unsigned char)upper] = true;
+        }
+    }
+    // the uppercase letters are already at their positions
+    for (unsigned int c = 0; c < 256; c++) {
+        if (!hasLowercase[c])
+            continue;
+        const int letter = letterIndex(c);
+        if (letter < 0) {
+            words.clear();
+            return words;
+        }
+        words &= countWords(letter, counts[c]);
+    }
+    return words;
+}
+
+WordSet LetterIndex::patternWords(const string &guess, unsigned int pattern) const {
+    d_assert(guess.size() == m_wordLength);
+    WordSet words(m_numberWords, true);
+    unsigned int colors[m_wordLength];
+    for (unsigned int i = 0; i < m_wordLength; i++) {
+        colors[i] = pattern % 3;
+        pattern /= 3;
+    }
+
+    // A letter is misplaced (1) at the first positions of the guess where it isn't well placed (2)
+    // as long as the word has more of it, then absent (0): the number of the well placed and
+    // misplaced letters is the minimal count of the letter in the word, exact if it is absent at
+    // a position.
+    bool seen[256] = {false};
+    for (unsigned int i = 0; i < m_wordLength; i++) {
+        const unsigned char c = guess[i];
+        const int letter = letterIndex(c);
+        if (colors[i] == 2) {
+            if (letter < 0) {
+                words.clear();
+                return words;
+            }
+            words &= positionWords(letter, i);
+        } else if (letter >= 0) {
+            words.subtract(positionWords(letter, i));
+        }
+        if (seen[c])
+            continue;
+        seen[c] = true;
+
+        unsigned int found = 0;
+        bool absent = false;
+        for (unsigned int j = i; j < m_wordLength; j++) {
+            if ((unsigned char)guess[j] != c)
+                continue;
+            if (colors[j] == 0) {
+                absent = true;
+            } else if (colors[j] == 1 && absent) {
+                // misplaced after an absent one: no word gives this pattern
+                words.clear();
+                return words;
+            } else {
+                found++;
+            }
+        }
+        if (found > 0 && letter < 0) {
+            words.clear();
+            return words;
+        }
+        if (found > 0)
+            words &= countWords(letter, found);
+        if (absent && found < m_wordLength && letter >= 0)
+            words.subtract(countWords(letter, found + 1));
+    }
+    return words;
+}
+
+unsigned int LetterIndex::numberOfWords() const { return m_numberWords; }
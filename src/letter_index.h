@@ -0,0 +1,76 @@
+#ifndef SRC_LETTER_INDEX_H_
+#define SRC_LETTER_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A set of words of a dictionary, one bit per word.
+ */
+class WordSet {
+  public:
+    WordSet(unsigned int size = 0, bool full = false);
+
+    // number of words of the dictionary
+    unsigned int size() const;
+    bool contains(unsigned int word) const { return (m_blocks[word / 64] >> (word % 64)) & 1; }
+    void insert(unsigned int word) { m_blocks[word / 64] |= uint64_t(1) << (word % 64); }
+    void clear();
+    // keeps the words of both sets
+    WordSet &operator&=(const WordSet &set);
+    // removes the words of the set
+    void subtract(const WordSet &set);
+    // the words in the set, in the same order
+    std::vector<int> filter(const std::vector<int> &words) const;
+
+  private:
+    unsigned int m_size;
+    std::vector<uint64_t> m_blocks;
+};
+
+/**
+ * @brief The words of a dictionary with each letter at each position, and with at least a number
+ * of each letter.
+ *
+ * A mask or the pattern of a guess is a constraint on the letters at some positions and on the
+ * number of some letters, so the words respecting it are found with a few intersections of these
+ * sets, without the pattern matrix.
+ */
+class LetterIndex {
+  public:
+    LetterIndex();
+
+    // empties the index and prepares it for the words
+    void reset(unsigned int wordLength, unsigned int numberWords);
+    void setWord(unsigned int word, const std::string &letters);
+
+    /**
+     * @brief The words respecting the mask.
+     *
+     * @param mask an uppercase letter is at its position, the lowercase letters are in the other
+     * positions, the other characters are ignored (all the words if its length is wrong)
+     */
+    WordSet maskWords(const std::string &mask) const;
+    // the words which give the pattern when the guess is played, none if no word can give it
+    WordSet patternWords(const std::string &guess, unsigned int pattern) const;
+    unsigned int numberOfWords() const;
+
+  private:
+    // index of the letter in the sets, -1 if no word has it
+    int letterIndex(char letter) const;
+    const WordSet &positionWords(int letter, unsigned int position) const;
+    // count from 1 to the length of the words
+    const WordSet &countWords(int letter, unsigned int count) const;
+
+    unsigned int m_wordLength;
+    unsigned int m_numberWords;
+    // [character] = index of the letter, -1 if no word has it
+    int m_letters[256];
+    // [letter * length + position] = the words with the letter at the position
+    std::vector<WordSet> m_positionWords;
+    // [letter * length + count - 1] = the words with at least count times the letter
+    std::vector<WordSet> m_countWords;
+};
+
+#endif // !SRC_LETTER_INDEX_H_
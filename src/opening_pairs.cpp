@@ -0,0 +1,391 @@
+#include "opening_pairs.h"
+#include "entropy.h"
+#include "utils.h"
+#include "word_list.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+using namespace std;
+
+const string PAIRS_FILE_HEADER = "WordleSutom-pairs";
+const int PAIRS_FILE_VERSION = 1;
+// margin of the bounds, for the rounding errors of the entropies
+constexpr double BOUND_MARGIN = 1e-9;
+
+// the first pairs are the best ones, the ties are ordered by words
+static bool isBetter(const OpeningPair &pair1, const OpeningPair &pair2) {
+    if (pair1.entropy != pair2.entropy)
+        return pair1.entropy > pair2.entropy;
+    if (pair1.first != pair2.first)
+        return pair1.first < pair2.first;
+    return pair1.second < pair2.second;
+}
+
+// The key of a checkpoint: it is only resumed by the search of the same pairs of the same words.
+static string checkpointKey(const WordList &wordList, const OpeningPairsSpec &spec) {
+    ostringstream key;
+    key << wordList.dictionary().name << " " << wordList.numberOfWords() << " "
+        << wordList.numberOfAnswers() << " " << wordList.wordsChecksum() << " " << spec.number;
+    return key.str();
+}
+
+// Reads the first words done and the pairs kept by a previous search, false if there is none.
+static bool loadCheckpoint(const WordList &wordList, const OpeningPairsSpec &spec,
+                           vector<int> &doneWords, vector<OpeningPair> &pairs) {
+    ifstream file(spec.checkpointPath);
+    string header;
+    int version;
+    if (!(file >> header >> version) || header != PAIRS_FILE_HEADER ||
+        version != PAIRS_FILE_VERSION)
+        return false;
+
+    string line;
+    getline(file, line);
+    if (!getline(file, line) || line != "key " + checkpointKey(wordList, spec)) {
+        cerr << "The checkpoint \"" << spec.checkpointPath
+             << "\" is from another search, it is ignored.\n";
+        return false;
+    }
+
+    doneWords.clear();
+    pairs.clear();
+    while (getline(file, line)) {
+        istringstream values(line);
+        string key;
+        if (!(values >> key))
+            continue;
+
+        if (key == "done") {
+            string word;
+            while (values >> word) {
+                doneWords.push_back(wordList.getWordIndex(word));
+            }
+        } else if (key == "pair") {
+            string first, second;
+            OpeningPair pair;
+            values >> first >> second >> pair.entropy >> pair.sets;
+            pair.first = wordList.getWordIndex(first);
+            pair.second = wordList.getWordIndex(second);
+            if (values.fail() || pair.first < 0 || pair.second < 0) {
+                doneWords.clear();
+                break;
+            }
+            pairs.push_back(pair);
+        }
+    }
+
+    if (file.bad() || count(doneWords.begin(), doneWords.end(), -1) > 0) {
+        cerr << "An error occurred while reading the checkpoint \"" << spec.checkpointPath
+             << "\".\n";
+        pairs.clear();
+        return false;
+    }
+    return true;
+}
+
+// Writes a temporary file then renames it: an interrupted search leaves the previous checkpoint.
+static bool saveCheckpoint(const WordList &wordList, const OpeningPairsSpec &spec,
+                           const vector<int> &doneWords, const vector<OpeningPair> &pairs) {
+    const string temporaryPath = uniqueTemporaryPath(spec.checkpointPath);
+    {
+        ofstream file(temporaryPath);
+        file.precision(17);
+        file << PAIRS_FILE_HEADER << " " << PAIRS_FILE_VERSION << "\n";
+        file << "key " << checkpointKey(wordList, spec) << "\n";
+        file << "done";
+        for (int word : doneWords) {
+            file << " " << wordList.getWord(word).word;
+        }
+        file << "\n";
+        for (const OpeningPair &pair : pairs) {
+            file << "pair " << wordList.getWord(pair.first).word << " "
+                 << wordList.getWord(pair.second).word << " " << pair.entropy << " "
+                 << pair.sets << "\n";
+        }
+        if (!file) {
+            cerr << "Cannot write the checkpoint \"" << temporaryPath << "\".\n";
+            file.close();
+            remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+    if (!publishFile(temporaryPath, spec.checkpointPath)) {
+        cerr << "Cannot replace the checkpoint \"" << spec.checkpointPath << "\".\n";
+        return false;
+    }
+    return true;
+}
+
+vector<OpeningPair> searchOpeningPairs(const WordList &wordList, const OpeningPairsSpec &spec,
+                                       OpeningPairsStats *stats) {
+    const vector<int> candidates = wordList.guessWords();
+    const vector<int> answers = wordList.initialCompatibleWords();
+    const unsigned int numberAnswers = answers.size();
+    const unsigned int numberPattern = ::pow(3, wordList.wordLength());
+    const unsigned int threads =
+        spec.threads > 0 ? spec.threads : max(thread::hardware_concurrency(), 1u);
+    if (stats != nullptr)
+        *stats = OpeningPairsStats();
+    if (spec.number <= 0 || candidates.size() < 2 || numberAnswers <= 0)
+        return vector<OpeningPair>();
+
+    // the words by decreasing entropy: a word is the first word of its pairs with the next ones
+    const vector<double> wordEntropies = wordList.entropies(candidates, answers);
+    vector<unsigned int> order(candidates.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&wordEntropies](unsigned int i, unsigned int j) {
+        return wordEntropies[i] > wordEntropies[j] ||
+               (wordEntropies[i] == wordEntropies[j] && i < j);
+    });
+    vector<int> words(order.size());
+    vector<double> entropies(order.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        words[i] = candidates[order[i]];
+        entropies[i] = wordEntropies[order[i]];
+    }
+    const unsigned int numberWords = words.size();
+
+    const vector<double> nLogN = nLogNTable(numberAnswers);
+    const double maxEntropy = log2(numberAnswers);
+
+    // the pairs kept, sorted, and the entropy a pair must reach to be kept
+    vector<OpeningPair> pairs;
+    mutex pairsMutex;
+    atomic<double> threshold(-INFINITY);
+    const auto addPair = [&](const OpeningPair &pair) {
+        lock_guard<mutex> lock(pairsMutex);
+        if (pairs.size() >= spec.number && !isBetter(pair, pairs.back()))
+            return;
+        const auto position = upper_bound(pairs.begin(), pairs.end(), pair, isBetter);
+        // a pair of the checkpoint is found again if its first word wasn't done
+        if (position != pairs.begin() && prev(position)->first == pair.first &&
+            prev(position)->second == pair.second)
+            return;
+        pairs.insert(position, pair);
+        if (pairs.size() > spec.number)
+            pairs.pop_back();
+        if (pairs.size() >= spec.number)
+            threshold = pairs.back().entropy;
+    };
+
+    // [position] = the pairs of the word at this position are done
+    unique_ptr<atomic<bool>[]> done(new atomic<bool>[numberWords]);
+    for (unsigned int i = 0; i < numberWords; i++) {
+        done[i] = false;
+    }
+    if (!spec.checkpointPath.empty()) {
+        vector<int> doneWords;
+        vector<OpeningPair> savedPairs;
+        if (loadCheckpoint(wordList, spec, doneWords, savedPairs)) {
+            // [word] = position of the word + 1, 0 if it isn't a candidate
+            vector<unsigned int> positions(wordList.numberOfWords(), 0);
+            for (unsigned int i = 0; i < numberWords; i++) {
+                positions[words[i]] = i + 1;
+            }
+            for (int word : doneWords) {
+                if (positions[word])
+                    done[positions[word] - 1] = true;
+            }
+            for (const OpeningPair &pair : savedPairs) {
+                addPair(pair);
+            }
+        }
+    }
+
+    mutex checkpointMutex;
+    auto lastCheckpoint = chrono::steady_clock::now();
+    const auto checkpoint = [&]() {
+        vector<int> doneWords;
+        // [word] = its pairs are done
+        vector<bool> isDone(wordList.numberOfWords(), false);
+        for (unsigned int i = 0; i < numberWords; i++) {
+            if (done[i]) {
+                doneWords.push_back(words[i]);
+                isDone[words[i]] = true;
+            }
+        }
+        // the pairs of the other first words are searched again when the search is resumed
+        vector<OpeningPair> savedPairs;
+        {
+            lock_guard<mutex> lock(pairsMutex);
+            for (const OpeningPair &pair : pairs) {
+                if (isDone[pair.first])
+                    savedPairs.push_back(pair);
+            }
+        }
+        saveCheckpoint(wordList, spec, doneWords, savedPairs);
+        if (spec.onCheckpoint)
+            spec.onCheckpoint(doneWords.size(), numberWords);
+    };
+
+    atomic<unsigned int> nextWord(0);
+    mutex statsMutex;
+    auto worker = [&]() {
+        OpeningPairsStats localStats;
+        // the answers grouped by the pattern of the first word, without the single ones
+        vector<int> grouped;
+        // [group] = end of the group in grouped
+        vector<unsigned int> groupEnds;
+        // [group] = smallest sum of count * log2(count) of the sets of the group and the next ones
+        vector<double> minimalSums;
+        vector<unsigned int> counts(numberPattern, 0);
+        vector<unsigned int> usedPatterns;
+        vector<vector<int>> buckets(numberPattern);
+
+        unsigned int i;
+        while ((i = nextWord++) < numberWords) {
+            if (done[i])
+                continue;
+            // The next first words have lower entropies, their pairs can't be kept either.
+            if (i + 1 >= numberWords ||
+                entropies[i] + entropies[i + 1] + BOUND_MARGIN < threshold.load()) {
+                done[i] = true;
+                localStats.firstWords++;
+                continue;
+            }
+
+            const int first = words[i];
+            for (vector<int> &bucket : buckets) {
+                bucket.clear();
+            }
+            wordList.patternMatrix().visitRow(first, [&](const auto &row) {
+                row.forEach(answers,
+                            [&](int answer, unsigned int pattern) {
+                                buckets[pattern].push_back(answer);
+                            });
+            });
+            // the big groups first, the bound of the pair drops quickly
+            vector<vector<int> *> groups;
+            unsigned int singles = 0;
+            for (vector<int> &bucket : buckets) {
+                if (bucket.size() > 1)
+                    groups.push_back(&bucket);
+                else
+                    singles += bucket.size();
+            }
+            sort(groups.begin(), groups.end(),
+                 [](const vector<int> *group1, const vector<int> *group2) {
+                     return group1->size() > group2->size();
+                 });
+            grouped.clear();
+            groupEnds.clear();
+            for (const vector<int> *group : groups) {
+                grouped.insert(grouped.end(), group->begin(), group->end());
+                groupEnds.push_back(grouped.size());
+            }
+            // a group is at best split in numberPattern sets of the same size
+            const unsigned int numberGroups = groups.size();
+            minimalSums.assign(numberGroups + 1, 0);
+            for (unsigned int g = numberGroups; g-- > 0;) {
+                const double size = groups[g]->size();
+                minimalSums[g] =
+                    minimalSums[g + 1] + max(0.0, size * log2(size / numberPattern));
+            }
+
+            for (unsigned int j = i + 1; j < numberWords; j++) {
+                const double currentThreshold = threshold.load();
+                if (min(entropies[i] + entropies[j], maxEntropy) + BOUND_MARGIN <
+                    currentThreshold)
+                    break;
+
+                localStats.evaluated++;
+                double sum = 0;
+                unsigned int sets = singles;
+                bool stopped = false;
+                wordList.patternMatrix().visitRow(words[j], [&](const auto &row) {
+                    unsigned int start = 0;
+                    for (unsigned int g = 0; g < numberGroups; g++) {
+                        usedPatterns.clear();
+                        for (unsigned int a = start; a < groupEnds[g]; a++) {
+                            const unsigned int pattern = row[grouped[a]];
+                            if (!counts[pattern]++)
+                                usedPatterns.push_back(pattern);
+                        }
+                        for (unsigned int pattern : usedPatterns) {
+                            sum += nLogN[counts[pattern]];
+                            counts[pattern] = 0;
+                        }
+                        sets += usedPatterns.size();
+                        start = groupEnds[g];
+
+                        const double bound =
+                            (nLogN[numberAnswers] - sum - minimalSums[g + 1]) / numberAnswers;
+                        if (bound + BOUND_MARGIN < currentThreshold) {
+                            stopped = true;
+                            return;
+                        }
+                    }
+                });
+                if (stopped) {
+                    localStats.stopped++;
+                    continue;
+                }
+
+                OpeningPair pair;
+                pair.first = first;
+                pair.second = words[j];
+                pair.entropy = (nLogN[numberAnswers] - sum) / numberAnswers;
+                pair.sets = sets;
+                if (pair.entropy >= currentThreshold)
+                    addPair(pair);
+            }
+
+            done[i] = true;
+            localStats.firstWords++;
+            if (!spec.checkpointPath.empty()) {
+                unique_lock<mutex> lock(checkpointMutex, try_to_lock);
+                const auto now = chrono::steady_clock::now();
+                if (lock.owns_lock() && chrono::duration<double>(now - lastCheckpoint).count() >=
+                                            spec.checkpointInterval) {
+                    lastCheckpoint = now;
+                    checkpoint();
+                }
+            }
+        }
+
+        lock_guard<mutex> lock(statsMutex);
+        if (stats != nullptr) {
+            stats->firstWords += localStats.firstWords;
+            stats->evaluated += localStats.evaluated;
+            stats->stopped += localStats.stopped;
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int t = 0; t < threads; t++) {
+        workers.emplace_back(worker);
+    }
+    for (thread &t : workers) {
+        t.join();
+    }
+    if (!spec.checkpointPath.empty())
+        checkpoint();
+    return pairs;
+}
+
+bool saveOpeningPairs(const string &path, const WordList &wordList,
+                      const vector<OpeningPair> &pairs) {
+    ofstream file(path);
+    if (!file) {
+        cerr << "Cannot open the file \"" << path << "\".\n";
+        return false;
+    }
+
+    for (const OpeningPair &pair : pairs) {
+        file << wordList.getWord(pair.first).word << " " << wordList.getWord(pair.second).word
+             << " " << pair.entropy << " " << pair.sets << "\n";
+    }
+    return bool(file);
+}
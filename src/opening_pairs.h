@@ -0,0 +1,63 @@
+#ifndef SRC_OPENING_PAIRS_H_
+#define SRC_OPENING_PAIRS_H_
+
+#include "word_list.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+struct OpeningPair {
+    // the first word has the highest entropy alone
+    int first;
+    int second;
+    // entropy of the partition of the answers by the patterns of both words (bits)
+    double entropy;
+    // number of sets of the partition
+    unsigned int sets;
+};
+
+struct OpeningPairsSpec {
+    // number of pairs kept
+    unsigned int number = 100;
+    // the number of cores if 0
+    unsigned int threads = 0;
+    // the progress is saved in this file and read back when the search is run again, empty to
+    // never save it
+    std::string checkpointPath;
+    // seconds between two checkpoints
+    double checkpointInterval = 60;
+    // called after each checkpoint with the number of first words done
+    std::function<void(unsigned int done, unsigned int total)> onCheckpoint;
+};
+
+struct OpeningPairsStats {
+    // first words whose pairs have been searched (or pruned) by this run
+    unsigned int firstWords = 0;
+    // pairs whose partition has been counted, entirely or until it was pruned
+    unsigned long long evaluated = 0;
+    // pairs stopped before the end of their partition
+    unsigned long long stopped = 0;
+};
+
+/**
+ * @brief The pairs of guesses which split the answers the most, for a fixed two words opening.
+ *
+ * The entropy of a pair is at most the sum of the entropies of its words: the words are sorted by
+ * entropy, each one is paired with the next ones until this bound is below the entropy of the last
+ * pair kept. The answers are grouped by the pattern of the first word, the sets of the pair are the
+ * sets of the patterns of the second word in each group, so the count of a pair stops as soon as
+ * the groups left can't make it good enough.
+ *
+ * The first words are distributed over the threads, the search restarts from the checkpoint of the
+ * same dictionary and number of pairs.
+ *
+ * @return the pairs, by decreasing entropy
+ */
+std::vector<OpeningPair> searchOpeningPairs(const WordList &wordList,
+                                            const OpeningPairsSpec &spec = OpeningPairsSpec(),
+                                            OpeningPairsStats *stats = nullptr);
+// one pair per line: the words, the entropy and the number of sets
+bool saveOpeningPairs(const std::string &path, const WordList &wordList,
+                      const std::vector<OpeningPair> &pairs);
+
+#endif // !SRC_OPENING_PAIRS_H_
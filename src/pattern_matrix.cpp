@@ -0,0 +1,241 @@
+#include "pattern_matrix.h"
+#include "utils.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+using namespace std;
+
+// bytes read after the end of the data by readBits()
+constexpr unsigned int DATA_PADDING = 4;
+// size of the huge pages, the matrix is aligned on it
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+PatternMatrix::PatternMatrix(PatternStorage storage)
+    : m_storage(storage), m_guesses(0), m_answers(0), m_patternBits(0), m_patterns(), m_tiles(),
+      m_data(), m_readyRows(), m_missingRows(0), m_requestedRow(-1), m_rowsMutex(),
+      m_rowsCondition() {}
+
+void PatternMatrix::reset(unsigned int numberGuesses, unsigned int numberAnswers,
+                          unsigned int numberPatterns) {
+    d_assert(numberAnswers <= numberGuesses);
+    clear();
+    m_guesses = numberGuesses;
+    m_answers = numberAnswers;
+    m_readyRows.reset(new atomic<bool>[numberGuesses]);
+    for (unsigned int i = 0; i < numberGuesses; i++) {
+        m_readyRows[i] = false;
+    }
+    m_missingRows = numberGuesses;
+    while ((1u << m_patternBits) < numberPatterns) {
+        m_patternBits++;
+    }
+
+    if (m_storage == PatternStorage::Compressed) {
+        const unsigned int tilesPerRow = (numberAnswers + TILE_SIZE - 1) / TILE_SIZE;
+        m_tiles.reserve((size_t)tilesPerRow * numberGuesses);
+        m_data.assign(DATA_PADDING, 0);
+    } else {
+        // not initialized, the pages are only allocated when the rows are set
+        m_patterns = allocatePatterns((size_t)numberGuesses * numberAnswers);
+    }
+}
+
+void PatternMatrix::setRow(unsigned int guess, const unsigned int *patterns) {
+    d_assert(guess < m_guesses);
+    if (m_storage == PatternStorage::Compressed) {
+        d_assert(m_tiles.size() == (size_t)guess * ((m_answers + TILE_SIZE - 1) / TILE_SIZE));
+        compressRow(patterns);
+    } else {
+        copy(patterns, patterns + m_answers, m_patterns.get() + (size_t)guess * m_answers);
+    }
+
+    d_assert(!m_readyRows[guess]);
+    {
+        lock_guard<mutex> lock(m_rowsMutex);
+        m_readyRows[guess].store(true, memory_order_release);
+        m_missingRows--;
+        int requested = guess;
+        m_requestedRow.compare_exchange_strong(requested, -1);
+    }
+    m_rowsCondition.notify_all();
+}
+
+bool PatternMatrix::isComplete() const { return m_missingRows.load(memory_order_acquire) <= 0; }
+
+bool PatternMatrix::isRowReady(unsigned int guess) const {
+    d_assert(guess < m_guesses);
+    return m_readyRows[guess].load(memory_order_acquire);
+}
+
+void PatternMatrix::waitForRow(unsigned int guess) const {
+    if (isRowReady(guess))
+        return;
+    unique_lock<mutex> lock(m_rowsMutex);
+    // requested again after each row, another thread may have replaced the request
+    while (!isRowReady(guess)) {
+        m_requestedRow = guess;
+        m_rowsCondition.wait(lock);
+    }
+}
+
+int PatternMatrix::requestedRow() const { return m_requestedRow; }
+
+unique_ptr<unsigned int[], PatternMatrix::PatternsDeleter>
+PatternMatrix::allocatePatterns(size_t size) {
+#ifdef __linux__
+    // The rows are read at scattered answers, with 4 KB pages most reads of a big matrix miss the
+    // TLB. Explicit huge pages are used if some are reserved, else transparent ones are requested.
+    const size_t bytes = (size * sizeof(unsigned int) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+                         HUGE_PAGE_SIZE;
+    if (PATTERN_MATRIX_HUGE_PAGES && bytes >= HUGE_PAGE_SIZE) {
+        void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (data == MAP_FAILED) {
+            data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data != MAP_FAILED)
+                madvise(data, bytes, MADV_HUGEPAGE);
+        }
+        if (data != MAP_FAILED)
+            return unique_ptr<unsigned int[], PatternsDeleter>((unsigned int *)data, {bytes});
+    }
+#endif
+    return unique_ptr<unsigned int[], PatternsDeleter>(new unsigned int[size], {0});
+}
+
+void PatternMatrix::PatternsDeleter::operator()(unsigned int *patterns) const {
+#ifdef __linux__
+    if (bytes > 0) {
+        munmap(patterns, bytes);
+        return;
+    }
+#endif
+    delete[] patterns;
+}
+
+void PatternMatrix::compressRow(const unsigned int *patterns) {
+    // [pattern] = index in the dictionary of the tile + 1, 0 if not in it
+    thread_local vector<unsigned int> indices;
+    if (indices.size() < (1u << m_patternBits))
+        indices.resize(1u << m_patternBits, 0);
+    vector<unsigned int> dictionary;
+    dictionary.reserve(TILE_SIZE);
+
+    m_data.resize(m_data.size() - DATA_PADDING);
+    for (unsigned int start = 0; start < m_answers; start += TILE_SIZE) {
+        const unsigned int end = min(start + TILE_SIZE, m_answers);
+        dictionary.clear();
+        for (unsigned int answer = start; answer < end; answer++) {
+            if (!indices[patterns[answer]]) {
+                dictionary.push_back(patterns[answer]);
+                indices[patterns[answer]] = dictionary.size();
+            }
+        }
+
+        Tile tile;
+        tile.offset = m_data.size();
+        tile.indexBits = 0;
+        tile.dictionarySize = dictionary.size();
+        while ((1u << tile.indexBits) < dictionary.size()) {
+            tile.indexBits++;
+        }
+        m_tiles.push_back(tile);
+
+        // indices of a full tile then the dictionary, packed with the lowest bits first
+        const size_t dictionaryOffset = m_data.size() + tile.indexBits * (TILE_SIZE / 8);
+        m_data.resize(dictionaryOffset + (dictionary.size() * m_patternBits + 7) / 8 +
+                          DATA_PADDING,
+                      0);
+        auto writeBits = [this](size_t offset, unsigned int bit, unsigned int value) {
+            for (; value; value >>= 1, bit++) {
+                m_data[offset + bit / 8] |= (value & 1) << (bit % 8);
+            }
+        };
+        for (unsigned int answer = start; answer < end; answer++) {
+            writeBits(tile.offset, (answer - start) * tile.indexBits,
+                      indices[patterns[answer]] - 1);
+        }
+        for (unsigned int i = 0; i < dictionary.size(); i++) {
+            writeBits(dictionaryOffset, i * m_patternBits, dictionary[i]);
+            indices[dictionary[i]] = 0;
+        }
+        m_data.resize(m_data.size() - DATA_PADDING);
+    }
+    m_data.resize(m_data.size() + DATA_PADDING, 0);
+}
+
+void PatternMatrix::clear() {
+    m_guesses = 0;
+    m_answers = 0;
+    m_readyRows.reset();
+    m_missingRows = 0;
+    m_requestedRow = -1;
+    m_patternBits = 0;
+    m_patterns.reset();
+    m_tiles = vector<Tile>();
+    m_data = vector<uint8_t>();
+}
+
+unsigned int PatternMatrix::pattern(unsigned int answer, unsigned int guess) const {
+    d_assert(answer < m_answers && guess < m_guesses);
+    return visitRow(guess, [answer](const auto &row) { return row[answer]; });
+}
+
+PatternMatrix::RawRow PatternMatrix::rawRow(unsigned int guess) const {
+    return RawRow(m_patterns.get() + (size_t)guess * m_answers);
+}
+
+PatternMatrix::CompressedRow PatternMatrix::compressedRow(unsigned int guess) const {
+    const unsigned int tilesPerRow = (m_answers + TILE_SIZE - 1) / TILE_SIZE;
+    return CompressedRow(m_tiles.data() + (size_t)guess * tilesPerRow, m_data.data(),
+                         m_patternBits);
+}
+
+PatternStorage PatternMatrix::storage() const { return m_storage; }
+
+unsigned int PatternMatrix::numberOfGuesses() const { return m_guesses; }
+
+unsigned int PatternMatrix::numberOfAnswers() const { return m_answers; }
+
+bool PatternMatrix::empty() const { return m_guesses <= 0; }
+
+size_t PatternMatrix::memoryUsage() const {
+    const size_t rawSize = m_patterns ? (size_t)m_guesses * m_answers : 0;
+    return rawSize * sizeof(unsigned int) + m_tiles.size() * sizeof(Tile) + m_data.size();
+}
+
+GatheredPatterns::GatheredPatterns(const PatternMatrix &matrix, const vector<int> &answers)
+    : m_matrix(matrix), m_answers(answers), m_columns(matrix.numberOfAnswers(), -1),
+      m_rows(matrix.numberOfGuesses(), -1), m_patterns() {
+    for (unsigned int i = 0; i < answers.size(); i++) {
+        m_columns[answers[i]] = i;
+    }
+}
+
+const vector<int> &GatheredPatterns::answers() const { return m_answers; }
+
+bool GatheredPatterns::contains(const vector<int> &answers) const {
+    return all_of(answers.begin(), answers.end(), [this](int answer) {
+        return 0 <= answer && answer < (int)m_columns.size() && m_columns[answer] >= 0;
+    });
+}
+
+bool GatheredPatterns::isGathered(unsigned int guess) const { return m_rows[guess] >= 0; }
+
+GatheredPatterns::Row GatheredPatterns::row(unsigned int guess) const {
+    d_assert(guess < m_rows.size());
+    if (m_rows[guess] < 0) {
+        m_rows[guess] = m_patterns.size();
+        m_patterns.resize(m_patterns.size() + m_answers.size());
+        uint16_t *patterns = m_patterns.data() + m_rows[guess];
+        m_matrix.visitRow(guess, [&](const auto &row) {
+            row.forEach(m_answers, [&patterns](int, unsigned int pattern) {
+                *patterns++ = pattern;
+            });
+        });
+    }
+    return Row(m_patterns.data() + m_rows[guess], m_columns.data(), m_answers.size());
+}
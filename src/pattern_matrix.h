@@ -0,0 +1,328 @@
+#ifndef SRC_PATTERN_MATRIX_H_
+#define SRC_PATTERN_MATRIX_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum class PatternStorage {
+    // One unsigned int per pattern.
+    Raw,
+    // Rows cut in tiles, each one stored as indices in its own dictionary of patterns.
+    Compressed,
+};
+
+#define DEFAULT_PATTERN_STORAGE PatternStorage::Raw
+
+// The raw matrix is allocated on huge pages when the system allows it.
+#define PATTERN_MATRIX_HUGE_PAGES true
+// The patterns of the raw rows are prefetched this number of answers ahead in the loops over a set
+// of answers (0 to never prefetch them).
+#define PATTERN_PREFETCH_DISTANCE 32
+
+/**
+ * @brief Matrix of the patterns of every guess against every answer.
+ *
+ * The answers are the first words: the answer of index i is the guess of index i.
+ *
+ * The rows (one per guess) are read through rawRow() or compressedRow(), visitRow() calls a
+ * function with the row of the storage used so that the loops are compiled for each storage.
+ *
+ * With the raw storage, the rows can be set by a thread while others read the matrix: the readers
+ * wait for the rows they read (see waitForRow()).
+ */
+class PatternMatrix {
+  public:
+    // number of answers in a tile of the compressed storage
+    static constexpr unsigned int TILE_SIZE = 256;
+    // a tile is decoded at once when at least this number of its answers are read
+    static constexpr unsigned int MIN_DECODED_ANSWERS = 32;
+
+    struct Tile {
+        // offset in m_data of the indices, followed by the dictionary
+        uint32_t offset;
+        // number of bits of an index
+        uint16_t indexBits;
+        uint16_t dictionarySize;
+    };
+
+    class RawRow {
+      public:
+        RawRow(const unsigned int *patterns) : m_patterns(patterns) {}
+        unsigned int operator[](unsigned int answer) const { return m_patterns[answer]; }
+        const unsigned int *data() const { return m_patterns; }
+
+        // calls function(answer, pattern) for each answer
+        template <class Function>
+        void forEach(const std::vector<int> &answers, Function function) const {
+            const unsigned int size = answers.size();
+            for (unsigned int i = 0; i < size; i++) {
+                prefetch(answers, i);
+                function(answers[i], m_patterns[answers[i]]);
+            }
+        }
+
+        // same as forEach() but stops when the function returns false
+        template <class Function>
+        void forEachWhile(const std::vector<int> &answers, Function function) const {
+            const unsigned int size = answers.size();
+            for (unsigned int i = 0; i < size; i++) {
+                prefetch(answers, i);
+                if (!function(answers[i], m_patterns[answers[i]]))
+                    return;
+            }
+        }
+
+      private:
+        // prefetches the pattern read PATTERN_PREFETCH_DISTANCE answers after the i-th one
+        void prefetch(const std::vector<int> &answers, unsigned int i) const {
+            if (PATTERN_PREFETCH_DISTANCE > 0 && i + PATTERN_PREFETCH_DISTANCE < answers.size())
+                __builtin_prefetch(m_patterns + answers[i + PATTERN_PREFETCH_DISTANCE]);
+        }
+
+        const unsigned int *m_patterns;
+    };
+
+    class CompressedRow {
+      public:
+        CompressedRow(const Tile *tiles, const uint8_t *data, unsigned int patternBits)
+            : m_tiles(tiles), m_data(data), m_patternBits(patternBits) {}
+
+        unsigned int operator[](unsigned int answer) const {
+            const Tile &tile = m_tiles[answer / TILE_SIZE];
+            const uint8_t *indices = m_data + tile.offset;
+            const unsigned int index = readBits(indices, (answer % TILE_SIZE) * tile.indexBits,
+                                                tile.indexBits);
+            // the dictionary is after the indices of a full tile
+            return readBits(indices + tile.indexBits * (TILE_SIZE / 8), index * m_patternBits,
+                            m_patternBits);
+        }
+
+        // patterns of all the answers of the tile
+        void decodeTile(unsigned int tile, unsigned int *patterns) const {
+            const Tile &header = m_tiles[tile];
+            const uint8_t *indices = m_data + header.offset;
+            const uint8_t *dictionaryData = indices + header.indexBits * (TILE_SIZE / 8);
+            unsigned int dictionary[TILE_SIZE];
+            for (unsigned int i = 0; i < header.dictionarySize; i++) {
+                dictionary[i] = readBits(dictionaryData, i * m_patternBits, m_patternBits);
+            }
+            for (unsigned int i = 0; i < TILE_SIZE; i++) {
+                patterns[i] = dictionary[readBits(indices, i * header.indexBits, header.indexBits)];
+            }
+        }
+
+        /**
+         * @brief Calls function(answer, pattern) for each answer.
+         *
+         * The tiles containing many consecutive answers are decoded at once, the answers should be
+         * sorted.
+         */
+        template <class Function>
+        void forEach(const std::vector<int> &answers, Function function) const {
+            forEachWhile(answers, [&function](int answer, unsigned int pattern) {
+                function(answer, pattern);
+                return true;
+            });
+        }
+
+        // same as forEach() but stops when the function returns false
+        template <class Function>
+        void forEachWhile(const std::vector<int> &answers, Function function) const {
+            unsigned int patterns[TILE_SIZE];
+            const unsigned int size = answers.size();
+            unsigned int i = 0;
+            while (i < size) {
+                const unsigned int tile = answers[i] / TILE_SIZE;
+                unsigned int end = i + 1;
+                while (end < size && answers[end] / TILE_SIZE == tile) {
+                    end++;
+                }
+
+                if (end - i >= MIN_DECODED_ANSWERS) {
+                    decodeTile(tile, patterns);
+                    for (; i < end; i++) {
+                        if (!function(answers[i], patterns[answers[i] % TILE_SIZE]))
+                            return;
+                    }
+                } else {
+                    for (; i < end; i++) {
+                        if (!function(answers[i], (*this)[answers[i]]))
+                            return;
+                    }
+                }
+            }
+        }
+
+      private:
+        const Tile *m_tiles;
+        const uint8_t *m_data;
+        unsigned int m_patternBits;
+    };
+
+    PatternMatrix(PatternStorage storage = DEFAULT_PATTERN_STORAGE);
+
+    /**
+     * @brief Empties the matrix and prepares it for the rows of the guesses.
+     *
+     * @param numberAnswers number of columns of a row, at most the number of guesses
+     * @param numberPatterns the patterns are below this value
+     */
+    void reset(unsigned int numberGuesses, unsigned int numberAnswers,
+               unsigned int numberPatterns);
+    // the rows must be set in order with the compressed storage
+    void setRow(unsigned int guess, const unsigned int *patterns);
+    void clear();
+
+    // all the rows are set
+    bool isComplete() const;
+    bool isRowReady(unsigned int guess) const;
+    // waits until the row is set, it is then set first by the thread using requestedRow()
+    void waitForRow(unsigned int guess) const;
+    // the row a reader waits for, -1 if none
+    int requestedRow() const;
+
+    unsigned int pattern(unsigned int answer, unsigned int guess) const;
+    // the row must be ready
+    RawRow rawRow(unsigned int guess) const;
+    CompressedRow compressedRow(unsigned int guess) const;
+    template <class Function> auto visitRow(unsigned int guess, Function function) const {
+        if (!isComplete())
+            waitForRow(guess);
+        if (m_storage == PatternStorage::Compressed)
+            return function(compressedRow(guess));
+        return function(rawRow(guess));
+    }
+
+    PatternStorage storage() const;
+    // number of rows
+    unsigned int numberOfGuesses() const;
+    // number of columns
+    unsigned int numberOfAnswers() const;
+    bool empty() const;
+    // bytes used by the patterns
+    std::size_t memoryUsage() const;
+
+    // bits [offset, offset + bits) of data, bits is at most 25
+    static unsigned int readBits(const uint8_t *data, unsigned int offset, unsigned int bits) {
+        uint32_t word;
+        std::memcpy(&word, data + offset / 8, sizeof(word));
+        return (word >> (offset % 8)) & ((1u << bits) - 1);
+    }
+
+  private:
+    // frees the raw matrix, allocated by allocatePatterns()
+    struct PatternsDeleter {
+        std::size_t bytes;
+        void operator()(unsigned int *patterns) const;
+    };
+
+    static std::unique_ptr<unsigned int[], PatternsDeleter> allocatePatterns(std::size_t size);
+    void compressRow(const unsigned int *patterns);
+
+    PatternStorage m_storage;
+    unsigned int m_guesses;
+    unsigned int m_answers;
+    // number of bits of a pattern in the dictionaries
+    unsigned int m_patternBits;
+    // [answer + guess * number of answers] = pattern, with the raw storage
+    std::unique_ptr<unsigned int[], PatternsDeleter> m_patterns;
+    // [tile + guess * number of tiles of a row], with the compressed storage
+    std::vector<Tile> m_tiles;
+    std::vector<uint8_t> m_data;
+
+    // [guess] = the row is set
+    std::unique_ptr<std::atomic<bool>[]> m_readyRows;
+    std::atomic<unsigned int> m_missingRows;
+    mutable std::atomic<int> m_requestedRow;
+    mutable std::mutex m_rowsMutex;
+    mutable std::condition_variable m_rowsCondition;
+};
+
+/**
+ * @brief Patterns of the guesses against a few answers, copied in a dense block.
+ *
+ * The row of a guess is gathered from the matrix the first time it is read, then it is read from
+ * the block: the rows of the guesses evaluated at each turn stay in the cache instead of reading
+ * scattered cells of the matrix. The answers read must be some of the answers of the block.
+ * The rows are gathered by const methods, an instance can't be shared by threads.
+ */
+class GatheredPatterns {
+  public:
+    // the patterns are stored on 16 bits
+    static constexpr unsigned int MAX_PATTERNS = 1 << 16;
+
+    class Row {
+      public:
+        Row(const uint16_t *patterns, const int *columns, unsigned int size)
+            : m_patterns(patterns), m_columns(columns), m_size(size) {}
+        unsigned int operator[](unsigned int answer) const {
+            return m_patterns[m_columns[answer]];
+        }
+
+        // calls function(answer, pattern) for each answer
+        template <class Function>
+        void forEach(const std::vector<int> &answers, Function function) const {
+            if (answers.size() == m_size) {
+                // all the answers of the block, in the same order
+                for (unsigned int i = 0; i < m_size; i++) {
+                    function(answers[i], m_patterns[i]);
+                }
+            } else {
+                for (int answer : answers) {
+                    function(answer, m_patterns[m_columns[answer]]);
+                }
+            }
+        }
+
+        // same as forEach() but stops when the function returns false
+        template <class Function>
+        void forEachWhile(const std::vector<int> &answers, Function function) const {
+            if (answers.size() == m_size) {
+                for (unsigned int i = 0; i < m_size; i++) {
+                    if (!function(answers[i], m_patterns[i]))
+                        return;
+                }
+            } else {
+                for (int answer : answers) {
+                    if (!function(answer, m_patterns[m_columns[answer]]))
+                        return;
+                }
+            }
+        }
+
+      private:
+        const uint16_t *m_patterns;
+        const int *m_columns;
+        unsigned int m_size;
+    };
+
+    /**
+     * @param answers the answers of the block (sorted), the matrix must outlive the block
+     */
+    GatheredPatterns(const PatternMatrix &matrix, const std::vector<int> &answers);
+
+    const std::vector<int> &answers() const;
+    // the answers can be read from the block
+    bool contains(const std::vector<int> &answers) const;
+    bool isGathered(unsigned int guess) const;
+    Row row(unsigned int guess) const;
+    template <class Function> auto visitRow(unsigned int guess, Function function) const {
+        return function(row(guess));
+    }
+
+  private:
+    const PatternMatrix &m_matrix;
+    const std::vector<int> m_answers;
+    // [answer] = column of the answer in the block, -1 if not in it
+    std::vector<int> m_columns;
+    // [guess] = offset of the row of the guess in m_patterns, -1 if not gathered yet
+    mutable std::vector<int> m_rows;
+    mutable std::vector<uint16_t> m_patterns;
+};
+
+#endif // !SRC_PATTERN_MATRIX_H_
@@ -0,0 +1,328 @@
+#include "simulation.h"
+#include "alias_table.h"
+#include "game.h"
+#include "gameResolver.h"
+#include "utils.h"
+#include "word_list.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+using namespace std;
+
+const string SIMULATION_FILE_HEADER = "WordleSutom-simulation";
+const int SIMULATION_FILE_VERSION = 1;
+
+double SimulationResult::averageSteps() const {
+    unsigned int totalSteps = 0;
+    for (unsigned int steps = 0; steps < histogram.size(); steps++) {
+        totalSteps += steps * histogram[steps];
+    }
+    // the lost games count for the maximal number of guesses
+    totalSteps += losses * spec.maxSteps;
+    return games ? (double)totalSteps / games : 0;
+}
+
+double SimulationResult::confidenceHalfWidth(double z) const {
+    if (games < 2)
+        return INFINITY;
+    const double average = averageSteps();
+    double variance = losses * (spec.maxSteps - average) * (spec.maxSteps - average);
+    for (unsigned int steps = 0; steps < histogram.size(); steps++) {
+        variance += histogram[steps] * (steps - average) * (steps - average);
+    }
+    variance /= games - 1;
+    return z * sqrt(variance / games);
+}
+
+bool SimulationResult::merge(const SimulationResult &result) {
+    if (result.wordLength != wordLength || result.dictionary != dictionary ||
+        result.settings != settings || result.spec.seed != spec.seed ||
+        result.spec.shardCount != spec.shardCount || result.spec.sampleSize != spec.sampleSize ||
+        result.spec.maxSteps != spec.maxSteps ||
+        result.spec.objective.type != spec.objective.type ||
+        result.spec.objective.worstCaseWeight != spec.objective.worstCaseWeight)
+        return false;
+    for (unsigned int shard : result.shards) {
+        if (shard >= spec.shardCount || find(shards.begin(), shards.end(), shard) != shards.end())
+            return false;
+    }
+
+    shards.insert(shards.end(), result.shards.begin(), result.shards.end());
+    sort(shards.begin(), shards.end());
+    games += result.games;
+    losses += result.losses;
+    if (histogram.size() < result.histogram.size())
+        histogram.resize(result.histogram.size(), 0);
+    for (unsigned int steps = 0; steps < result.histogram.size(); steps++) {
+        histogram[steps] += result.histogram[steps];
+    }
+    return true;
+}
+
+bool SimulationResult::isComplete() const { return shards.size() == spec.shardCount; }
+
+// Plays the game of the answer and returns the number of guesses, 0 if it is lost.
+static unsigned int playGame(Game &game, GameResolver &gameResolver, int answer) {
+    game.reset(answer);
+    gameResolver.reset();
+    while (game.gameStatus() <= 0) {
+        gameResolver.update(game.update(gameResolver.bestChoice().word));
+    }
+    return game.gameStatus() == 2 ? game.numberSteps() : 0;
+}
+
+vector<int> simulationAnswers(const WordList &wordList, const SimulationSpec &spec) {
+    if (spec.shard >= spec.shardCount)
+        return {};
+
+    vector<int> answers = wordList.initialCompatibleWords();
+    const unsigned int size = answers.size();
+
+    if (spec.sampleSize > 0 && spec.sampleSize < size) {
+        mt19937_64 generator(spec.seed);
+        for (unsigned int i = 0; i < spec.sampleSize; i++) {
+            swap(answers[i], answers[randomInt(generator, i, size)]);
+        }
+        answers.resize(spec.sampleSize);
+        sort(answers.begin(), answers.end());
+    }
+
+    // interleaved, so that the shards are balanced
+    vector<int> shardAnswers;
+    for (unsigned int i = spec.shard; i < answers.size(); i += spec.shardCount) {
+        shardAnswers.push_back(answers[i]);
+    }
+    return shardAnswers;
+}
+
+SimulationResult simulate(const WordList &wordList, const SimulationSpec &spec,
+                          unsigned int threads) {
+    const vector<int> answers = simulationAnswers(wordList, spec);
+    if (threads <= 0)
+        threads = max(thread::hardware_concurrency(), 1u);
+
+    SimulationResult result;
+    result.wordLength = wordList.wordLength();
+    result.dictionary = wordList.dictionary().name;
+    result.settings = wordList.settingsKey();
+    result.spec = spec;
+    result.shards.push_back(spec.shard);
+    result.histogram.resize(spec.maxSteps + 1, 0);
+
+    atomic<unsigned int> nextAnswer(0);
+    mutex resultMutex;
+    auto worker = [&]() {
+        vector<unsigned int> histogram(spec.maxSteps + 1, 0);
+        unsigned int games = 0;
+        unsigned int losses = 0;
+
+        Game game(wordList, spec.maxSteps, spec.seed);
+        GameResolver gameResolver(wordList);
+        gameResolver.setObjective(spec.objective);
+        unsigned int a;
+        while ((a = nextAnswer++) < answers.size()) {
+            const unsigned int steps = playGame(game, gameResolver, answers[a]);
+            games++;
+            if (steps > 0)
+                histogram[steps]++;
+            else
+                losses++;
+        }
+
+        lock_guard<mutex> lock(resultMutex);
+        result.games += games;
+        result.losses += losses;
+        for (unsigned int steps = 0; steps <= spec.maxSteps; steps++) {
+            result.histogram[steps] += histogram[steps];
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    for (thread &t : workers) {
+        t.join();
+    }
+    return result;
+}
+
+SimulationResult monteCarlo(const WordList &wordList, const MonteCarloSpec &spec,
+                            unsigned int threads) {
+    if (threads <= 0)
+        threads = max(thread::hardware_concurrency(), 1u);
+
+    const vector<int> answers = wordList.initialCompatibleWords();
+    vector<double> weights;
+    for (int w : answers) {
+        const Word word = wordList.getWord(w);
+        weights.push_back(spec.frequencyWeights ? word.frq : word.score);
+    }
+    const AliasTable answersTable(weights);
+
+    SimulationResult result;
+    result.wordLength = wordList.wordLength();
+    result.dictionary = wordList.dictionary().name;
+    result.settings = wordList.settingsKey();
+    result.spec.seed = spec.seed;
+    result.spec.maxSteps = spec.maxSteps;
+    result.shards.push_back(0);
+    result.histogram.resize(spec.maxSteps + 1, 0);
+    // [i] = number of guesses of the i-th game of the batch (0 if lost)
+    vector<unsigned int> batch(max(spec.batchSize, 1u));
+
+    auto isPrecise = [&]() {
+        return result.games >= spec.minGames &&
+               result.confidenceHalfWidth(spec.z) <= spec.maxHalfWidth;
+    };
+    while (result.games < spec.maxGames && !isPrecise()) {
+        const unsigned int firstGame = result.games;
+        const unsigned int batchSize = min<unsigned int>(batch.size(), spec.maxGames - firstGame);
+        atomic<unsigned int> nextGame(0);
+
+        auto worker = [&]() {
+            Game game(wordList, spec.maxSteps, spec.seed);
+            GameResolver gameResolver(wordList);
+            unsigned int i;
+            while ((i = nextGame++) < batchSize) {
+                mt19937_64 generator(spec.seed ^ ((firstGame + i) * 0x9e3779b97f4a7c15));
+                const int answer = answers[answersTable.sample(generator)];
+                batch[i] = playGame(game, gameResolver, answer);
+            }
+        };
+
+        vector<thread> workers;
+        for (unsigned int i = 0; i < min(threads, batchSize); i++) {
+            workers.emplace_back(worker);
+        }
+        for (thread &t : workers) {
+            t.join();
+        }
+
+        for (unsigned int i = 0; i < batchSize; i++) {
+            result.games++;
+            if (batch[i] > 0)
+                result.histogram[batch[i]]++;
+            else
+                result.losses++;
+        }
+    }
+    return result;
+}
+
+bool saveSimulationResult(const string &path, const SimulationResult &result) {
+    ofstream file(path);
+    if (!file) {
+        cerr << "Cannot open the file \"" << path << "\".\n";
+        return false;
+    }
+
+    file << SIMULATION_FILE_HEADER << " " << SIMULATION_FILE_VERSION << "\n";
+    file << "length " << result.wordLength << "\n";
+    if (!result.dictionary.empty())
+        file << "dictionary " << result.dictionary << "\n";
+    file.precision(17);
+    file << "settings " << result.settings << "\n";
+    file << "objective " << (int)result.spec.objective.type << " "
+         << result.spec.objective.worstCaseWeight << "\n";
+    file << "seed " << result.spec.seed << "\n";
+    file << "shardCount " << result.spec.shardCount << "\n";
+    file << "sampleSize " << result.spec.sampleSize << "\n";
+    file << "maxSteps " << result.spec.maxSteps << "\n";
+    file << "games " << result.games << "\n";
+    file << "losses " << result.losses << "\n";
+    file << "shards";
+    for (unsigned int shard : result.shards) {
+        file << " " << shard;
+    }
+    file << "\nhistogram";
+    for (unsigned int count : result.histogram) {
+        file << " " << count;
+    }
+    file << "\n";
+    return bool(file);
+}
+
+bool loadSimulationResult(const string &path, SimulationResult &result) {
+    ifstream file(path);
+    string header;
+    int version;
+    if (!(file >> header >> version) || header != SIMULATION_FILE_HEADER ||
+        version != SIMULATION_FILE_VERSION) {
+        cerr << "The file \"" << path << "\" isn't a simulation result.\n";
+        return false;
+    }
+
+    result = SimulationResult();
+    string line;
+    while (getline(file, line)) {
+        istringstream values(line);
+        string key;
+        if (!(values >> key))
+            continue;
+
+        if (key == "length")
+            values >> result.wordLength;
+        else if (key == "dictionary")
+            values >> result.dictionary;
+        else if (key == "settings")
+            getline(values >> ws, result.settings);
+        else if (key == "objective") {
+            int type = 0;
+            values >> type >> result.spec.objective.worstCaseWeight;
+            result.spec.objective.type = (GuessObjective)type;
+        } else if (key == "seed")
+            values >> result.spec.seed;
+        else if (key == "shardCount")
+            values >> result.spec.shardCount;
+        else if (key == "sampleSize")
+            values >> result.spec.sampleSize;
+        else if (key == "maxSteps")
+            values >> result.spec.maxSteps;
+        else if (key == "games")
+            values >> result.games;
+        else if (key == "losses")
+            values >> result.losses;
+        else if (key == "shards")
+            result.shards.assign(istream_iterator<unsigned int>(values), {});
+        else if (key == "histogram")
+            result.histogram.assign(istream_iterator<unsigned int>(values), {});
+    }
+
+    // each shard once, among the shards of the simulation
+    vector<unsigned int> shards = result.shards;
+    sort(shards.begin(), shards.end());
+    const bool validShards = !shards.empty() && shards.back() < result.spec.shardCount &&
+                             adjacent_find(shards.begin(), shards.end()) == shards.end();
+    if (file.bad() || !validShards) {
+        cerr << "An error occurred while reading the file \"" << path << "\".\n";
+        return false;
+    }
+    return true;
+}
+
+bool mergeSimulationResults(const vector<string> &paths, SimulationResult &result) {
+    bool first = true;
+    for (const string &path : paths) {
+        SimulationResult shardResult;
+        if (!loadSimulationResult(path, shardResult))
+            return false;
+
+        if (first) {
+            result = shardResult;
+            first = false;
+        } else if (!result.merge(shardResult)) {
+            cerr << "The file \"" << path << "\" doesn't come from the same simulation.\n";
+            return false;
+        }
+    }
+    return !first;
+}
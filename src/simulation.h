@@ -0,0 +1,97 @@
+#ifndef SRC_SIMULATION_H_
+#define SRC_SIMULATION_H_
+
+#include "word_list.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct SimulationSpec {
+    uint64_t seed = 0;
+    // the answers are split in shardCount shards, this run plays the shard-th one
+    unsigned int shard = 0;
+    unsigned int shardCount = 1;
+    // number of answers drawn (with the seed) from all the answers, 0 to play all of them
+    unsigned int sampleSize = 0;
+    unsigned int maxSteps = 20;
+    // what the guesses minimize
+    Objective objective;
+};
+
+struct MonteCarloSpec {
+    uint64_t seed = 0;
+    // the answers are drawn proportionally to their frequency, or to their score if false
+    bool frequencyWeights = true;
+    // the simulation stops when the confidence interval of the mean number of guesses is smaller
+    // than +/- maxHalfWidth (z: 1.96 for 95%)
+    double z = 1.96;
+    double maxHalfWidth = 0.02;
+    unsigned int minGames = 200;
+    unsigned int maxGames = 100000;
+    // the games are played by batches, the stop condition is checked between them
+    unsigned int batchSize = 64;
+    unsigned int maxSteps = 20;
+};
+
+struct SimulationResult {
+    unsigned int wordLength = 0;
+    // name of the dictionary, empty in the results saved before the dictionaries
+    std::string dictionary;
+    // WordList::settingsKey() of the word list, empty in the results saved before the settings
+    std::string settings;
+    SimulationSpec spec;
+    // shards merged in this result
+    std::vector<unsigned int> shards;
+    unsigned int games = 0;
+    // [steps] = number of games won in this number of guesses
+    std::vector<unsigned int> histogram;
+    // games not found within the maximal number of guesses
+    unsigned int losses = 0;
+
+    double averageSteps() const;
+    // half width of the confidence interval of the average number of guesses
+    double confidenceHalfWidth(double z = 1.96) const;
+    // false if the results don't come from the same simulation, with the same settings
+    bool merge(const SimulationResult &result);
+    // all the shards have been merged
+    bool isComplete() const;
+};
+
+/**
+ * @brief The answers played by a shard.
+ *
+ * The list only depends on the word list and on the spec, so every node computes the same split.
+ */
+std::vector<int> simulationAnswers(const WordList &wordList, const SimulationSpec &spec);
+
+/**
+ * @brief Plays the games of a shard.
+ *
+ * @param threads the number of workers, the number of cores if 0 (the results don't depend on it)
+ */
+SimulationResult simulate(const WordList &wordList, const SimulationSpec &spec,
+                          unsigned int threads = 0);
+
+/**
+ * @brief Estimates the average number of guesses on answers drawn with their frequency.
+ *
+ * The answers are drawn with an alias table. The answer of the i-th game only depends on the seed
+ * and on i, and the stop condition is checked on whole batches so the results don't depend on the
+ * number of threads.
+ *
+ * @param threads the number of workers, the number of cores if 0
+ */
+SimulationResult monteCarlo(const WordList &wordList, const MonteCarloSpec &spec,
+                            unsigned int threads = 0);
+
+bool saveSimulationResult(const std::string &path, const SimulationResult &result);
+bool loadSimulationResult(const std::string &path, SimulationResult &result);
+/**
+ * @brief Merges the results files of the shards of a simulation.
+ *
+ * @param result the global result
+ * @return false if a file can't be read or doesn't come from the same simulation
+ */
+bool mergeSimulationResults(const std::vector<std::string> &paths, SimulationResult &result);
+
+#endif // !SRC_SIMULATION_H_
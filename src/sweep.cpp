@@ -0,0 +1,170 @@
+#include "sweep.h"
+#include "entropy.h"
+#include "word_list.h"
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+using namespace std;
+
+double SweepResult::averageSteps() const { return games ? (double)totalSteps / games : 0; }
+
+PartitionCache::PartitionCache(const WordList &wordList, unsigned int minCachedSize,
+                               size_t maxCachedBytes)
+    : m_wordList(wordList), m_candidates(wordList.guessWords()), m_minCachedSize(minCachedSize),
+      m_maxCachedSets(maxCachedBytes / max<size_t>(m_candidates.size() * sizeof(double), 1)),
+      m_mutex(), m_entropies() {}
+
+shared_ptr<const vector<double>> PartitionCache::compute(const vector<int> &possibleWords) const {
+    return make_shared<vector<double>>(m_wordList.entropies(m_candidates, possibleWords));
+}
+
+shared_ptr<const vector<double>> PartitionCache::entropies(const vector<int> &possibleWords) {
+    if (possibleWords.size() < m_minCachedSize)
+        return compute(possibleWords);
+
+    unique_lock<mutex> lock(m_mutex);
+    const auto it = m_entropies.find(possibleWords);
+    if (it != m_entropies.end()) {
+        // it may still be computed by another thread
+        const auto entropies = it->second;
+        lock.unlock();
+        return entropies.get();
+    }
+    if (m_entropies.size() >= m_maxCachedSets) {
+        lock.unlock();
+        return compute(possibleWords);
+    }
+
+    promise<shared_ptr<const vector<double>>> entropiesPromise;
+    m_entropies.emplace(possibleWords, entropiesPromise.get_future().share());
+    lock.unlock();
+
+    const auto entropies = compute(possibleWords);
+    entropiesPromise.set_value(entropies);
+    return entropies;
+}
+
+unsigned int PartitionCache::size() const {
+    lock_guard<mutex> lock(m_mutex);
+    return m_entropies.size();
+}
+
+// Same choice as the exact search of WordList::topWord (and GameResolver::bestChoice) with other
+// parameters: the big sets aren't sampled.
+static int bestGuess(const vector<int> &candidates, PartitionCache &cache,
+                     const ScoringParameters &parameters, const vector<double> &weights,
+                     const vector<int> &possibleWords) {
+    if (possibleWords.size() == 1)
+        return possibleWords.front();
+
+    const auto entropies = cache.entropies(possibleWords);
+
+    thread_local vector<double> possibleWeights;
+    possibleWeights.resize(possibleWords.size());
+    transform(possibleWords.begin(), possibleWords.end(), possibleWeights.begin(),
+              [&weights](int word) { return weights[word]; });
+    const double totalWeight = accumulate(possibleWeights.begin(), possibleWeights.end(), 0.);
+    const double possibilitiesEntropy = weightsEntropy(possibleWeights);
+
+    int bestWord = -1;
+    double bestScore = 10000;
+    // both lists are sorted
+    auto possibleIt = possibleWords.begin();
+    const int size = candidates.size();
+    for (int i = 0; i < size; i++) {
+        const int w = candidates[i];
+        while (possibleIt != possibleWords.end() && *possibleIt < w)
+            possibleIt++;
+        const bool isPossible = possibleIt != possibleWords.end() && *possibleIt == w;
+        const double p = isPossible ? weights[w] / totalWeight : 0;
+
+        const double score = parameters.score(possibilitiesEntropy, (*entropies)[i], p);
+        if (bestScore > score) {
+            bestWord = w;
+            bestScore = score;
+        }
+    }
+    return bestWord;
+}
+
+vector<SweepResult> sweepScoringParameters(const WordList &wordList,
+                                           const vector<ScoringParameters> &parameters,
+                                           vector<int> answers, unsigned int maxSteps,
+                                           unsigned int threads) {
+    const vector<int> candidates = wordList.guessWords();
+    const vector<int> initialPossibilities = wordList.initialCompatibleWords();
+    if (answers.empty())
+        answers = initialPossibilities;
+    if (threads <= 0)
+        threads = max(thread::hardware_concurrency(), 1u);
+
+    const unsigned int numberParameters = parameters.size();
+    vector<vector<double>> weights(numberParameters);
+    for (unsigned int k = 0; k < numberParameters; k++) {
+        for (unsigned int i = 0; i < wordList.numberOfWords(); i++) {
+            weights[k].push_back(parameters[k].wordScore(wordList.getWord(i).frq));
+        }
+    }
+
+    vector<SweepResult> results(numberParameters);
+    for (unsigned int k = 0; k < numberParameters; k++) {
+        results[k] = {parameters[k], 0, 0, 0, 0};
+    }
+
+    const vector<SweepResult> emptyResults = results;
+    PartitionCache cache(wordList);
+    atomic<unsigned int> nextAnswer(0);
+    mutex resultsMutex;
+
+    auto worker = [&]() {
+        vector<SweepResult> localResults = emptyResults;
+        unsigned int a;
+        while ((a = nextAnswer++) < answers.size()) {
+            const int answer = answers[a];
+            for (unsigned int k = 0; k < numberParameters; k++) {
+                vector<int> possibleWords = initialPossibilities;
+                unsigned int steps = 0;
+                bool found = false;
+                while (!found && steps < maxSteps) {
+                    const int guess =
+                        bestGuess(candidates, cache, parameters[k], weights[k], possibleWords);
+                    steps++;
+                    if (guess == answer) {
+                        found = true;
+                    } else {
+                        Step step;
+                        step.word = guess;
+                        step.pattern = wordList.getWordPattern(answer, guess);
+                        possibleWords = wordList.compatibleWords(possibleWords, step);
+                    }
+                }
+
+                SweepResult &result = localResults[k];
+                result.games++;
+                result.totalSteps += steps;
+                result.maxSteps = max(result.maxSteps, steps);
+                if (!found)
+                    result.losses++;
+            }
+        }
+
+        lock_guard<mutex> lock(resultsMutex);
+        for (unsigned int k = 0; k < numberParameters; k++) {
+            results[k].games += localResults[k].games;
+            results[k].totalSteps += localResults[k].totalSteps;
+            results[k].maxSteps = max(results[k].maxSteps, localResults[k].maxSteps);
+            results[k].losses += localResults[k].losses;
+        }
+    };
+
+    vector<thread> workers;
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+    for (thread &t : workers) {
+        t.join();
+    }
+    return results;
+}
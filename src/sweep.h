@@ -0,0 +1,79 @@
+#ifndef SRC_SWEEP_H_
+#define SRC_SWEEP_H_
+
+#include "word_list.h"
+#include <cstddef>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct SweepResult {
+    ScoringParameters parameters;
+    unsigned int games;
+    unsigned int totalSteps;
+    unsigned int maxSteps;
+    // games not found within the maximal number of steps
+    unsigned int losses;
+
+    double averageSteps() const;
+};
+
+/**
+ * @brief Entropies of every candidate word for possibility sets.
+ *
+ * The partition of a possibility set by a guess only depends on the pattern matrix, not on the
+ * weights of the words, so it is computed once and shared by all the scoring parameters (and all
+ * the games that reach the same set). Small sets are cheaper to recompute than to store.
+ *
+ * The entropies of a set take 8 bytes per candidate: once maxCachedBytes are used, the next sets
+ * are recomputed. The first sets cached are the ones close to the start of the games, reached by
+ * the most games.
+ */
+class PartitionCache {
+  public:
+    PartitionCache(const WordList &wordList, unsigned int minCachedSize = 32,
+                   std::size_t maxCachedBytes = std::size_t(1) << 30);
+
+    // entropy of each word of wordList.guessWords() for the possibility set
+    std::shared_ptr<const std::vector<double>> entropies(const std::vector<int> &possibleWords);
+    unsigned int size() const;
+
+  private:
+    std::shared_ptr<const std::vector<double>> compute(const std::vector<int> &possibleWords) const;
+
+    const WordList &m_wordList;
+    const std::vector<int> m_candidates;
+    const unsigned int m_minCachedSize;
+    // number of sets whose entropies fit in maxCachedBytes
+    const std::size_t m_maxCachedSets;
+    mutable std::mutex m_mutex;
+    std::map<std::vector<int>, std::shared_future<std::shared_ptr<const std::vector<double>>>>
+        m_entropies;
+};
+
+/**
+ * @brief Plays the games of each answer with each set of scoring parameters.
+ *
+ * The games are distributed over threads, each thread plays one answer with all the parameters
+ * so that the partitions it needs are already in the cache.
+ *
+ * The guesses are chosen with the exact search of topWord(): the sets of at least
+ * SamplingParameters::minPossibilities possibilities, whose entropies topWord() estimates on a
+ * sample, are scanned entirely.
+ *
+ * @param wordList the words, its own scoring parameters are not used
+ * @param parameters the sets of parameters to evaluate
+ * @param answers the words to find, all the compatible words if empty
+ * @param maxSteps the maximal number of guesses of a game
+ * @param threads the number of workers, the number of cores if 0
+ * @return the result of each set of parameters (in the same order)
+ */
+std::vector<SweepResult> sweepScoringParameters(const WordList &wordList,
+                                                const std::vector<ScoringParameters> &parameters,
+                                                std::vector<int> answers = {},
+                                                unsigned int maxSteps = 20,
+                                                unsigned int threads = 0);
+
+#endif // !SRC_SWEEP_H_
@@ -1,14 +1,95 @@
 #include "utils.h"
-#include <cstdlib>
-#include <ctime>
-#include <stdlib.h>
-bool initialised = false;
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+int lockFile(const std::string &path, bool *waited) {
+    if (waited != nullptr)
+        *waited = false;
+#ifdef __linux__
+    const int descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (descriptor < 0)
+        return -1;
+    if (flock(descriptor, LOCK_EX | LOCK_NB) == 0)
+        return descriptor;
+    if (waited != nullptr)
+        *waited = true;
+    while (flock(descriptor, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            close(descriptor);
+            return -1;
+        }
+    }
+    return descriptor;
+#else
+    return -1;
+#endif
+}
+
+void unlockFile(int descriptor) {
+#ifdef __linux__
+    // the lock is released with the descriptor
+    if (descriptor >= 0)
+        close(descriptor);
+#endif
+}
+
+std::string uniqueTemporaryPath(const std::string &path) {
+    static std::atomic<unsigned int> counter(0);
+#ifdef __linux__
+    const long process = getpid();
+#else
+    const long process = 0;
+#endif
+    return path + ".tmp." + std::to_string(process) + "." + std::to_string(counter++);
+}
+
+bool publishFile(const std::string &temporaryPath, const std::string &path) {
+    if (std::rename(temporaryPath.c_str(), path.c_str()) == 0)
+        return true;
+    std::remove(temporaryPath.c_str());
+    return false;
+}
+
+static uint64_t rotateLeft(uint64_t value, unsigned int bits) {
+    return value << bits | value >> (64 - bits);
+}
+
+uint64_t checksum(const void *data, std::size_t size, uint64_t seed) {
+    // 8 bytes per multiplication (a byte at a time is too slow for the pattern matrix)
+    constexpr uint64_t FACTOR1 = 0x87C37B91114253D5ull;
+    constexpr uint64_t FACTOR2 = 0x4CF5AD432745937Full;
+    const unsigned char *bytes = (const unsigned char *)data;
+    uint64_t hash = (seed + 1) * 0x9E3779B97F4A7C15ull ^ size;
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t value;
+        std::memcpy(&value, bytes + i, 8);
+        hash = rotateLeft(hash ^ value * FACTOR1, 31) * FACTOR2;
+    }
+    uint64_t last = 0;
+    std::memcpy(&last, bytes + i, size - i);
+    hash = rotateLeft(hash ^ last * FACTOR1, 31) * FACTOR2;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    return hash ^ hash >> 33;
+}
 
 int randomInt(int min, int max) {
+    thread_local std::mt19937_64 generator(std::random_device{}());
+    return randomInt(generator, min, max);
+}
+
+int randomInt(std::mt19937_64 &generator, int min, int max) {
     d_assert(min < max);
-    if (!initialised) {
-        srand(time(NULL));
-        initialised = true;
-    }
-    return rand() % (max - min) + min;
+    return generator() % (uint64_t)(max - min) + min;
 }
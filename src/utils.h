@@ -2,6 +2,9 @@
 #define SRC_UTILS_H_
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <random>
 #include <string>
 
 #define DEBUG 0
@@ -55,6 +58,24 @@ constexpr int pow(int x, int y) {
     }
 }
 
+/**
+ * @brief Takes the advisory lock of a file (created if needed), waits while another process holds
+ * it.
+ *
+ * @param waited set to true if another process held the lock
+ * @return the descriptor to give to unlockFile(), -1 if the file can't be locked
+ */
+int lockFile(const std::string &path, bool *waited = nullptr);
+void unlockFile(int descriptor);
+// A temporary file next to path, unique to the process and the call: no other writer uses it.
+std::string uniqueTemporaryPath(const std::string &path);
+// Replaces the file at path by the temporary file: the readers see the old file or the new one.
+bool publishFile(const std::string &temporaryPath, const std::string &path);
+// Checksum of the data to detect corrupted files, not a cryptographic hash.
+uint64_t checksum(const void *data, std::size_t size, uint64_t seed = 0);
+
 int randomInt(int min, int max);
+// Same results on every platform (unlike std::uniform_int_distribution).
+int randomInt(std::mt19937_64 &generator, int min, int max);
 
 #endif // !SRC_UTILS_H_
\ No newline at end of file
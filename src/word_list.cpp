@@ -5,65 +5,211 @@
 #include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 using namespace std;
 
-constexpr int patterCacheSize(int numberWords) { return numberWords * numberWords; }
-constexpr double entropyToScore(double entropy) {
+double ScoringParameters::entropyToScore(double entropy) const {
     if (entropy <= 1)
         return 1;
-    return 0.9 * log(entropy) + 1.5;
+    return entropyMul * log(entropy) + entropyOffset;
 }
 
-#define WORDS_UNIFORM_SCORE false
+double ScoringParameters::wordScore(float frequency) const {
+    if (uniformWeights)
+        return 1;
+    return tanh(frequency * frequencyMul + frequencyOffset) + 1;
+}
+
+double ScoringParameters::score(double possibilitiesEntropy, double wordEntropy,
+                                double probability) const {
+    const double entropyScore = entropyToScore(possibilitiesEntropy - wordEntropy) + 1;
+    return probability + (1 - probability) * entropyScore;
+}
+
+unsigned int SamplingParameters::sampleSize(unsigned int numberPatterns) const {
+    // The standard deviation of -log2(p) over numberPatterns patterns is below
+    // log2(numberPatterns) / 2 + 1 bits, the error of the mean over n words is divided by sqrt(n).
+    const double deviation = log2(max(numberPatterns, 2u)) / 2 + 1;
+    return ceil(deviation * deviation / (maxError * maxError));
+}
+
+bool ScoringParameters::isMonotonic() const { return entropyMul >= 0 && entropyOffset >= 1; }
+
+bool Objective::isBetter(const Evaluation &a, const Evaluation &b) const {
+    if (type == GuessObjective::WorstCase && a.largestBucket != b.largestBucket)
+        return a.largestBucket < b.largestBucket;
+    return cost(a) < cost(b);
+}
 
-#if !WORDS_UNIFORM_SCORE
-const double WORD_SCORE_MUL = 3;
-const double WORD_SCORE_OFFSET = -2;
-#endif
-string wordsPath(int wordLength) {
-    d_assert(4 <= wordLength && wordLength <= 12);
-    string filename = "data/words-" + to_string(wordLength) + ".txt";
+double Objective::cost(const Evaluation &evaluation) const {
+    d_assert(worstCaseWeight >= 0);
+    if (type == GuessObjective::Mixed)
+        return evaluation.score + worstCaseWeight * log2(max(evaluation.largestBucket, 1u));
+    return evaluation.score;
+}
+
+unsigned int Objective::maxBucket(const Evaluation &best, double minScore) const {
+    d_assert(worstCaseWeight >= 0);
+    if (type == GuessObjective::WorstCase)
+        return best.largestBucket;
+    if (type != GuessObjective::Mixed || worstCaseWeight <= 0)
+        return UINT_MAX;
+    // score + worstCaseWeight * log2(bucket) <= cost of the best word, with a margin for the
+    // rounding errors: a guess as good as the best one isn't stopped (it may come first)
+    const double bits = (cost(best) - minScore) / worstCaseWeight + 1e-9;
+    if (bits >= 32)
+        return UINT_MAX;
+    return bits >= 0 ? floor(exp2(bits)) : 0;
+}
+
+const string OPENING_FILE_HEADER = "WordleSutom-opening";
+const int OPENING_FILE_VERSION = 1;
+const char PATTERNS_FILE_MAGIC[4] = {'W', 'S', 'P', 'M'};
+const uint32_t PATTERNS_FILE_VERSION = 3;
+// magic, version, bytes of a pattern, number of guesses, number of answers (uint32_t), checksum of
+// the ordered words and checksum of the checksums of the rows (uint64_t), followed by the
+// checksums then the rows
+constexpr streamoff PATTERNS_HEADER_SIZE = 4 + 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+// Part of the entropy of a probability.
+static double entropyTerm(double p) { return p > 0 ? -p * log2(p) : 0; }
+
+Dictionary Dictionary::french(unsigned int wordLength) {
+    d_assert(MIN_FRENCH_WORD_LENGTH <= wordLength && wordLength <= MAX_WORD_LENGTH);
+    Dictionary dictionary;
+    dictionary.wordLength = wordLength;
+    dictionary.name = "words-" + to_string(wordLength);
+    return dictionary;
+}
+
+Dictionary Dictionary::english() {
+    Dictionary dictionary;
+    dictionary.wordLength = 5;
+    dictionary.name = "en-words-5";
+    // 2677 of the 12972 words, close to the number of answers of Wordle
+    dictionary.minAnswerFrequency = 1;
+    return dictionary;
+}
+
+bool Dictionary::fromName(const string &name, Dictionary &dictionary) {
+    if (name == "en") {
+        dictionary = english();
+        return true;
+    }
+    if (name.empty() || name.size() > 2 ||
+        !all_of(name.begin(), name.end(), [](char c) { return isdigit((unsigned char)c); }))
+        return false;
+    const unsigned int wordLength = stoi(name);
+    if (wordLength < MIN_FRENCH_WORD_LENGTH || wordLength > MAX_WORD_LENGTH)
+        return false;
+    dictionary = french(wordLength);
+    return true;
+}
+
+string wordsPath(const Dictionary &dictionary) {
+    string filename = "data/" + dictionary.name + ".txt";
     return filename;
 }
 
-string wordsMatrixPath(int wordLength) {
-    d_assert(4 <= wordLength && wordLength <= 12);
-    string filename = "data/words-" + to_string(wordLength) + "-patterns.cache.bin";
+string wordsMatrixPath(const Dictionary &dictionary) {
+    string filename = "data/" + dictionary.name + "-patterns.cache.bin";
+    return filename;
+}
+
+string openingPath(const Dictionary &dictionary) {
+    string filename = "data/" + dictionary.name + "-opening.cache.txt";
     return filename;
 }
 
 bool compareWords(const Word &a, const Word &b) { return a.word.compare(b.word) < 0; }
 
 WordList::WordList(unsigned int wordLength, const std::string &mask, bool loadFromCache,
-                   bool saveToCache)
-    : m_words(), m_wordsValids(), m_patternCache(nullptr) {
-    load(wordLength, mask, loadFromCache, saveToCache);
+                   bool saveToCache, PatternStorage storage)
+    : WordList(Dictionary::french(wordLength), mask, loadFromCache, saveToCache, storage) {}
+
+WordList::WordList(const Dictionary &dictionary, const std::string &mask, bool loadFromCache,
+                   bool saveToCache, PatternStorage storage)
+    : m_words(), m_wordsValids(), m_answersValids(), m_patternCache(storage), m_letterIndex(),
+      m_patternsLock(-1), m_wordsChecksum(0), m_saveToCache(saveToCache),
+      m_entropyBackend(DEFAULT_ENTROPY_BACKEND), m_loadingThread(), m_stopLoading(false),
+      m_openingMutex(), m_openingWord(), m_openingKey(), m_openingScore(0) {
+    load(dictionary, mask, loadFromCache, saveToCache);
 }
 
-void WordList::load(unsigned int wordLength, const std::string &mask, bool loadFromCache,
+void WordList::load(const Dictionary &dictionary, const std::string &mask, bool loadFromCache,
                     bool saveToCache) {
+    stopLoading();
     cout << "Loading word list.\n";
     auto clock = chrono::steady_clock();
     const auto start = clock.now();
 
-    m_wordsLength = wordLength;
+    m_dictionary = dictionary;
+    m_wordsLength = dictionary.wordLength;
+    m_saveToCache = saveToCache;
     cleanMask(mask);
     loadWords();
-    if (!loadFromCache || !loadPatterns()) {
-        generatePatterns(saveToCache);
+    m_wordsChecksum = wordsChecksum();
+    updateLetterIndex();
+    ifstream matrixFile;
+    unsigned int bytes = 0;
+    vector<uint64_t> checksums;
+    if (!loadFromCache || !openPatterns(matrixFile, bytes, checksums)) {
+        // Only one process generates the matrix, the others wait for it then read it. The
+        // process holding the lock always saves the matrix before releasing it: if there is
+        // still no cache, it couldn't be written and the waiting processes don't wait for each
+        // other.
+        if (saveToCache && !m_mask.size()) {
+            bool waited = false;
+            m_patternsLock = lockFile(wordsMatrixPath(m_dictionary) + ".lock", &waited);
+            if ((loadFromCache && ifstream(wordsMatrixPath(m_dictionary)) &&
+                 openPatterns(matrixFile, bytes, checksums)) ||
+                waited) {
+                unlockFile(m_patternsLock);
+                m_patternsLock = -1;
+            }
+        }
+        if (!matrixFile.is_open())
+            prepareGeneration();
     }
+    m_patternCache.reset(m_numberWords, m_numberAnswers, ::pow(3, m_wordsLength));
     // We remember compatible words.
     m_wordsValids.clear();
+    m_answersValids.clear();
+    const WordSet maskWords = m_letterIndex.maskWords(m_mask);
     for (unsigned int i = 0; i < m_numberWords; i++) {
-        if (isWordValid(m_words[i]))
+        if (maskWords.contains(i)) {
             m_wordsValids.push_back(i);
+            if (i < m_numberAnswers)
+                m_answersValids.push_back(i);
+        }
+    }
+    m_nLogN = nLogNTable(m_numberWords);
+    updateAnswersTable();
+    loadOpening();
+
+    // the compressed rows must be set in order, while they are read
+    m_stopLoading = false;
+    if (BACKGROUND_PATTERNS_LOADING && m_patternCache.storage() == PatternStorage::Raw) {
+        m_loadingThread =
+            thread(&WordList::fillPatterns, this, move(matrixFile), bytes, move(checksums),
+                   saveToCache);
+    } else {
+        fillPatterns(move(matrixFile), bytes, move(checksums), saveToCache);
     }
 
     const auto end = clock.now();
@@ -101,144 +247,284 @@ void WordList::cleanMask(const string &mask) {
 
 void WordList::loadWords() {
     cout << "Loading words.\n";
-    const string filePath = wordsPath(m_wordsLength);
+    m_words.clear();
+    const string filePath = wordsPath(m_dictionary);
     ifstream file(filePath);
     istream_iterator<Word> it(file);
     copy_if(it, istream_iterator<Word>(), back_inserter(m_words),
             [this](const Word &word) { return word.word.size() == m_wordsLength; });
+    for (Word &word : m_words) {
+        word.score = m_scoringParameters.wordScore(word.frq);
+    }
     sort(m_words.begin(), m_words.end(), &compareWords);
+
+    // the answers first, both parts stay sorted
+    vector<string> answers;
+    const bool hasAnswersFile = loadAnswers(answers);
+    const auto isAnswer = [&](const Word &word) {
+        if (hasAnswersFile)
+            return binary_search(answers.begin(), answers.end(), word.word);
+        return word.frq >= m_dictionary.minAnswerFrequency;
+    };
+    m_numberAnswers =
+        stable_partition(m_words.begin(), m_words.end(), isAnswer) - m_words.begin();
     m_numberWords = m_words.size();
+    if (m_numberAnswers < m_numberWords)
+        cout << m_numberAnswers << " answers among the " << m_numberWords << " words.\n";
+}
+
+bool WordList::loadAnswers(vector<string> &answers) const {
+    if (m_dictionary.answersPath.empty())
+        return false;
+    ifstream file(m_dictionary.answersPath);
+    if (!file) {
+        cerr << "Cannot open the file \"" << m_dictionary.answersPath
+             << "\" containing the answers.\n";
+        return false;
+    }
+
+    // the first word of each line, the rest (a frequency) is ignored
+    string line;
+    while (getline(file, line)) {
+        istringstream values(line);
+        string word;
+        if (values >> word) {
+            for_each(word.begin(), word.end(), [](char &c) { c = toupper(c); });
+            answers.push_back(word);
+        }
+    }
+    sort(answers.begin(), answers.end());
+    return true;
 }
 
-bool WordList::loadPatterns() {
+bool WordList::openPatterns(ifstream &matrixFile, unsigned int &bytes,
+                            vector<uint64_t> &checksums) const {
     cout << "Loading patterns.\n";
-    const string matrixPath = wordsMatrixPath(m_wordsLength);
-    ifstream matrixFile(matrixPath);
+    const string matrixPath = wordsMatrixPath(m_dictionary);
+    matrixFile.open(matrixPath, ios::in | ios::binary);
     if (!matrixFile) {
         cerr << "Cannot open the file \"" << matrixPath << "\" containing the matrix.\n";
         return false;
     }
 
-    bool errors = false;
-    const int matrixSize = patterCacheSize(m_numberWords);
-
-    if (m_patternCache != nullptr)
-        delete[] m_patternCache;
-    m_patternCache = new unsigned int[matrixSize];
-
-    char bytes;
-    matrixFile >> bytes;
-
-    if (bytes > 4 || !matrixFile) {
-        errors = true;
+    // the rows are read later, the header and the size of the file are checked now
+    char magic[4];
+    uint32_t version = 0, patternBytes = 0, guesses = 0, answers = 0;
+    uint64_t words = 0, checksumsChecksum = 0;
+    matrixFile.read(magic, sizeof(magic));
+    matrixFile.read((char *)&version, sizeof(version));
+    matrixFile.read((char *)&patternBytes, sizeof(patternBytes));
+    matrixFile.read((char *)&guesses, sizeof(guesses));
+    matrixFile.read((char *)&answers, sizeof(answers));
+    matrixFile.read((char *)&words, sizeof(words));
+    matrixFile.read((char *)&checksumsChecksum, sizeof(checksumsChecksum));
+    bytes = patternBytes;
+    const streamoff rowsOffset = PATTERNS_HEADER_SIZE + (streamoff)m_numberWords * sizeof(uint64_t);
+    bool valid = matrixFile && equal(magic, magic + 4, PATTERNS_FILE_MAGIC) &&
+                 version == PATTERNS_FILE_VERSION && bytes > 0 && bytes <= 4 &&
+                 guesses == m_numberWords && answers == m_numberAnswers &&
+                 words == m_wordsChecksum;
+    if (valid) {
+        matrixFile.seekg(0, ios::end);
+        valid = matrixFile.tellg() ==
+                rowsOffset + (streamoff)m_numberWords * m_numberAnswers * bytes;
     }
-
-    for (int i = 0; i < matrixSize && !errors; i++) {
-        matrixFile.read((char *)&m_patternCache[i], bytes);
-        // check that we can continue reading.
-        errors = !matrixFile && matrixFile.gcount() < matrixSize * bytes + 1;
+    if (!valid) {
+        matrixFile.close();
+        cerr << "The file \"" << matrixPath << "\" doesn't contain the matrix of the words.\n";
+        return false;
     }
 
-    if (errors) {
-        delete[] m_patternCache;
-        m_patternCache = nullptr;
-
-        cerr << "An error occurred while reading the file \"" << matrixPath
-             << "\" containing the matrix.\n";
+    checksums.resize(m_numberWords);
+    matrixFile.seekg(PATTERNS_HEADER_SIZE);
+    matrixFile.read((char *)checksums.data(), checksums.size() * sizeof(uint64_t));
+    if (!matrixFile ||
+        checksum(checksums.data(), checksums.size() * sizeof(uint64_t)) != checksumsChecksum) {
+        matrixFile.close();
+        cerr << "The file \"" << matrixPath << "\" containing the matrix is corrupted.\n";
         return false;
     }
-
-    cout << "Patterns loaded from file.\n";
     return true;
 }
 
-void WordList::generatePatterns(bool saveToCache) {
-    if (m_numberWords <= 0)
-        return;
-
+void WordList::prepareGeneration() {
     // If we generate patterns we don't need to save the words that doesn't respect the mask.
+    // the answers stay first
+    const WordSet maskWords = m_letterIndex.maskWords(m_mask);
     vector<Word> words;
-    copy_if(m_words.begin(), m_words.end(), back_inserter(words),
-            [this](const Word &word) { return isWordValid(word); });
+    for (unsigned int i = 0; i < m_numberAnswers; i++) {
+        if (maskWords.contains(i))
+            words.push_back(m_words[i]);
+    }
+    const unsigned int numberAnswers = words.size();
+    for (unsigned int i = m_numberAnswers; i < m_numberWords; i++) {
+        if (maskWords.contains(i))
+            words.push_back(m_words[i]);
+    }
     m_words = words;
     m_numberWords = m_words.size();
+    m_numberAnswers = numberAnswers;
+    m_wordsChecksum = wordsChecksum();
+    updateLetterIndex();
 
-    cout << "Generating pattern matrix (" << m_numberWords << " words).\n";
-    if (m_patternCache != nullptr)
-        delete[] m_patternCache;
-    m_patternCache = new unsigned int[patterCacheSize(m_numberWords)];
+    cout << "Generating pattern matrix (" << m_numberWords << " words, " << m_numberAnswers
+         << " answers).\n";
+}
 
-    for (unsigned int i = 0; i < m_numberWords; i++) {
-        const string word1 = getWord(i).word;
-        for (unsigned int j = 0; j < m_numberWords; j++) {
-            m_patternCache[i + j * m_numberWords] =
-                i == j ? ::pow(3, m_wordsLength) - 1 : getWordPattern(word1, getWord(j).word);
+void WordList::fillPatterns(ifstream matrixFile, unsigned int bytes, vector<uint64_t> checksums,
+                            bool saveToCache) {
+    const unsigned int numberPatterns = ::pow(3, m_wordsLength);
+    const bool anyOrder = m_patternCache.storage() == PatternStorage::Raw;
+    bool generated = !matrixFile.is_open();
+    // A matrix generated for the cache isn't given up when the loading is stopped: it is saved,
+    // the next runs (and the processes waiting for the lock) read it.
+    const bool forCache = saveToCache && !m_mask.size() && m_numberWords;
+    const auto isStopped = [&]() { return m_stopLoading && !(forCache && generated); };
+
+    vector<unsigned char> buffer(m_numberAnswers * bytes);
+    vector<unsigned int> row(m_numberAnswers);
+    // first row which may not be set, and row at the position of the file
+    unsigned int nextRow = 0;
+    unsigned int fileRow = 0;
+    const streamoff rowsOffset = PATTERNS_HEADER_SIZE + (streamoff)m_numberWords * sizeof(uint64_t);
+    unsigned int n = 0;
+    for (; n < m_numberWords && !isStopped(); n++) {
+
+        int guess = anyOrder ? m_patternCache.requestedRow() : -1;
+        if (guess < 0 || m_patternCache.isRowReady(guess)) {
+            while (m_patternCache.isRowReady(nextRow)) {
+                nextRow++;
+            }
+            guess = nextRow;
         }
+
+        if (matrixFile.is_open()) {
+            if ((unsigned int)guess != fileRow)
+                matrixFile.seekg(rowsOffset + (streamoff)guess * buffer.size());
+            matrixFile.read((char *)buffer.data(), buffer.size());
+            fileRow = guess + 1;
+            if (!matrixFile) {
+                // the other rows are generated
+                cerr << "An error occurred while reading the file \""
+                     << wordsMatrixPath(m_dictionary) << "\" containing the matrix.\n";
+                matrixFile.close();
+                generated = true;
+            } else if (checksum(buffer.data(), buffer.size(), guess) != checksums[guess]) {
+                cerr << "The row of " << m_words[guess].word << " is corrupted in the file \""
+                     << wordsMatrixPath(m_dictionary) << "\", the matrix is generated.\n";
+                matrixFile.close();
+                generated = true;
+            }
+        }
+
+        if (matrixFile.is_open()) {
+            for (unsigned int answer = 0; answer < m_numberAnswers; answer++) {
+                // little endian
+                unsigned int pattern = 0;
+                for (int b = bytes - 1; b >= 0; b--) {
+                    pattern = pattern << 8 | buffer[answer * bytes + b];
+                }
+                row[answer] = pattern;
+            }
+        } else {
+            const string &word2 = m_words[guess].word;
+            for (unsigned int i = 0; i < m_numberAnswers; i++) {
+                row[i] = i == (unsigned int)guess ? numberPatterns - 1
+                                                  : getWordPattern(m_words[i].word, word2);
+            }
+        }
+        m_patternCache.setRow(guess, row.data());
     }
 
-    // save matrix
-    if (!m_mask.size() && saveToCache && m_numberWords) {
-        cout << "Saving matrix.\n";
-        ofstream cacheFile(wordsMatrixPath(m_wordsLength), ios::out | ios::binary);
+    if (n == m_numberWords && forCache && generated) {
+        // the cache was corrupted, or this process waited for a cache which wasn't saved
+        if (m_patternsLock < 0)
+            m_patternsLock = lockFile(wordsMatrixPath(m_dictionary) + ".lock");
+        savePatterns();
+    }
+    unlockFile(m_patternsLock);
+    m_patternsLock = -1;
+}
+
+void WordList::savePatterns() const {
+    // the other processes never read a partial matrix
+    const string matrixPath = wordsMatrixPath(m_dictionary);
+    const string temporaryPath = uniqueTemporaryPath(matrixPath);
+    {
+        ofstream cacheFile(temporaryPath, ios::out | ios::binary | ios::trunc);
         if (!cacheFile) {
             cerr << "Cannot open the cache file !\n";
             return;
         }
 
         const int sizeRequired = ::pow(3, m_wordsLength);
-        char bytes = 0;
+        uint32_t bytes = 0;
         while (::pow(2, bytes * 8) < sizeRequired) {
             bytes++;
         }
-        cacheFile << bytes;
-        const int size = patterCacheSize(m_numberWords);
+        const uint32_t guesses = m_numberWords;
+        const uint32_t answers = m_numberAnswers;
+        const uint64_t words = m_wordsChecksum;
+        // the checksums are written once the rows are
+        vector<uint64_t> checksums(m_numberWords, 0);
+        uint64_t checksumsChecksum = 0;
+        cacheFile.write(PATTERNS_FILE_MAGIC, sizeof(PATTERNS_FILE_MAGIC));
+        cacheFile.write((const char *)&PATTERNS_FILE_VERSION, sizeof(PATTERNS_FILE_VERSION));
+        cacheFile.write((const char *)&bytes, sizeof(bytes));
+        cacheFile.write((const char *)&guesses, sizeof(guesses));
+        cacheFile.write((const char *)&answers, sizeof(answers));
+        cacheFile.write((const char *)&words, sizeof(words));
+        cacheFile.write((const char *)&checksumsChecksum, sizeof(checksumsChecksum));
+        cacheFile.write((const char *)checksums.data(), checksums.size() * sizeof(uint64_t));
+
+        vector<unsigned char> buffer(m_numberAnswers * bytes);
+        for (unsigned int j = 0; j < m_numberWords; j++) {
+            m_patternCache.visitRow(j, [&](const auto &row) {
+                for (unsigned int i = 0; i < m_numberAnswers; i++) {
+                    // little endian
+                    const unsigned int pattern = row[i];
+                    for (unsigned int b = 0; b < bytes; b++) {
+                        buffer[i * bytes + b] = pattern >> (8 * b);
+                    }
+                }
+            });
+            checksums[j] = checksum(buffer.data(), buffer.size(), j);
+            cacheFile.write((const char *)buffer.data(), buffer.size());
+        }
 
-        for (int i = 0; i < size; i++) {
-            cacheFile.write((char *)&m_patternCache[i], bytes);
+        checksumsChecksum = checksum(checksums.data(), checksums.size() * sizeof(uint64_t));
+        cacheFile.seekp(PATTERNS_HEADER_SIZE - sizeof(uint64_t));
+        cacheFile.write((const char *)&checksumsChecksum, sizeof(checksumsChecksum));
+        cacheFile.write((const char *)checksums.data(), checksums.size() * sizeof(uint64_t));
+        if (!cacheFile) {
+            cerr << "An error occurred while writing the cache file \"" << temporaryPath
+                 << "\".\n";
+            cacheFile.close();
+            remove(temporaryPath.c_str());
+            return;
         }
-        cout << "Matrix saved.\n";
     }
+    if (!publishFile(temporaryPath, matrixPath))
+        cerr << "Cannot replace the cache file \"" << matrixPath << "\".\n";
 }
 
-bool WordList::isWordValid(const Word &word) const {
-    if (m_mask.size() != m_wordsLength)
-        return true; // the mask is empty
-
-    bool usedLetters[m_wordsLength];
-    for (unsigned int i = 0; i < m_wordsLength; i++) {
-        const char c = m_mask[i];
-        if ('A' <= c && c <= 'Z') {
-            if (c != word.word[i])
-                return false;
-            usedLetters[i] = true;
-        } else {
-            usedLetters[i] = false;
-        }
+// Waits for the end of the generation of the matrix of the cache, stops its reading otherwise.
+void WordList::stopLoading() {
+    if (m_loadingThread.joinable()) {
+        m_stopLoading = true;
+        m_loadingThread.join();
     }
-    for (unsigned int i = 0; i < m_wordsLength; i++) {
-        char c = m_mask[i];
-        if ('a' <= c && c <= 'z') {
-            c = toupper(c);
-            bool found = false;
-            for (unsigned int j = 0; j < m_wordsLength; j++) {
-                if (!usedLetters[j] && c == word.word[j]) {
-                    found = true;
-                    usedLetters[j] = true;
-                    break;
-                }
-            }
-            if (!found)
-                return false;
-        }
-    }
-    return true;
 }
 
-WordList::~WordList() {
-    if (m_patternCache != nullptr)
-        delete[] m_patternCache;
+void WordList::updateLetterIndex() {
+    m_letterIndex.reset(m_wordsLength, m_numberWords);
+    for (unsigned int i = 0; i < m_numberWords; i++) {
+        m_letterIndex.setWord(i, m_words[i].word);
+    }
 }
 
+WordList::~WordList() { stopLoading(); }
+
 Word WordList::getWord(int index) const {
     d_assert(0 <= index && index < m_numberWords);
     return m_words[index];
@@ -247,19 +533,20 @@ Word WordList::getWord(int index) const {
 int WordList::getWordIndex(const std::string &word) const {
     Word word_s;
     word_s.word = word;
-    const auto it = lower_bound(m_words.begin(), m_words.end(), word_s, &compareWords);
-    if (it->word == word) {
-        d_assert(getWord(it - m_words.begin()).word == word);
-        return it - m_words.begin();
+    // the answers and the other words are sorted separately
+    const auto answersEnd = m_words.begin() + m_numberAnswers;
+    for (const auto &range : {make_pair(m_words.begin(), answersEnd),
+                              make_pair(answersEnd, m_words.end())}) {
+        const auto it = lower_bound(range.first, range.second, word_s, &compareWords);
+        if (it != range.second && it->word == word) {
+            d_assert(getWord(it - m_words.begin()).word == word);
+            return it - m_words.begin();
+        }
     }
     return -1;
 }
 
-bool WordList::doWordExist(const std::string &word) const {
-    Word word_s;
-    word_s.word = word;
-    return binary_search(m_words.begin(), m_words.end(), word_s, &compareWords);
-}
+bool WordList::doWordExist(const std::string &word) const { return getWordIndex(word) >= 0; }
 
 int WordList::getWordPattern(const std::string &word1, const std::string &word2) const {
     d_assert(word1.size() == word2.size() and word1.size() == m_wordsLength);
@@ -300,13 +587,13 @@ int WordList::getWordPattern(const std::string &word1, const std::string &word2)
 }
 
 int WordList::getWordPattern(int word1, int word2) const {
-    d_assert(0 <= word1 && word1 < m_numberWords);
+    d_assert(0 <= word1 && word1 < m_numberAnswers);
     d_assert(0 <= word2 && word2 < m_numberWords);
-    d_assert_l(m_patternCache[word1 + word2 * m_numberWords] ==
+    d_assert_l(m_patternCache.pattern(word1, word2) ==
                    getWordPattern(getWord(word1).word, getWord(word2).word),
                20);
 
-    return m_patternCache[word1 + word2 * m_numberWords];
+    return m_patternCache.pattern(word1, word2);
 }
 
 unsigned int WordList::numberOfWords() const {
@@ -314,6 +601,10 @@ unsigned int WordList::numberOfWords() const {
     return m_numberWords;
 }
 
+unsigned int WordList::numberOfAnswers() const { return m_numberAnswers; }
+
+bool WordList::isAnswer(int word) const { return 0 <= word && word < (int)m_numberAnswers; }
+
 double WordList::totalScore(const std::vector<int> &possibleWords) const {
     double totalScore = 0;
     const int size = possibleWords.size();
@@ -325,18 +616,34 @@ double WordList::totalScore(const std::vector<int> &possibleWords) const {
 
 double WordList::entropy(int word) const { return entropy(word, initialCompatibleWords()); }
 
-double WordList::entropy(int word, const vector<int> &possibleWords) const {
+double WordList::entropy(int word, const vector<int> &possibleWords,
+                         const GatheredPatterns *gathered) const {
+    if (m_entropyBackend == EntropyBackend::Fast)
+        return countsEntropy(word, possibleWords, nullptr, gathered);
+    return weightedEntropy(word, possibleWords);
+}
+
+double WordList::weightedEntropy(int word, const vector<int> &possibleWords,
+                                 unsigned int *largestBucket) const {
     const int numberPattern = ::pow(3, m_wordsLength);
 
     double scores[numberPattern];
     fill(scores, scores + numberPattern, 0);
     double totalScore = 0;
+    thread_local vector<unsigned int> counts;
+    if (largestBucket != nullptr) {
+        counts.assign(numberPattern, 0);
+        *largestBucket = 0;
+    }
 
     double score;
     for (int w : possibleWords) {
         score = m_words[word].score;
-        scores[m_patternCache[w + word * m_numberWords]] += score;
+        const unsigned int pattern = m_patternCache.pattern(w, word);
+        scores[pattern] += score;
         totalScore += score;
+        if (largestBucket != nullptr)
+            *largestBucket = max(*largestBucket, ++counts[pattern]);
     }
 
     double entropy = 0.f;
@@ -355,7 +662,184 @@ double WordList::entropy(int word, const vector<int> &possibleWords) const {
     return entropy / log(2.);
 }
 
+double WordList::countsEntropy(int word, const vector<int> &possibleWords,
+                               unsigned int *numberPatterns, const GatheredPatterns *gathered,
+                               unsigned int *largestBucket, unsigned int maxBucket) const {
+    // All the possible words have the same weight in the pattern buckets, so the entropy only
+    // depends on the number of words in each bucket:
+    // entropy = log2(n) - sum(count * log2(count)) / n
+    // Only the buckets that are used are read back (there are 3^length buckets).
+    const unsigned int size = possibleWords.size();
+    if (numberPatterns != nullptr)
+        *numberPatterns = 0;
+    if (largestBucket != nullptr)
+        *largestBucket = 0;
+    if (size <= 0)
+        return 0;
+
+    thread_local vector<unsigned int> counts;
+    thread_local vector<unsigned int> usedPatterns;
+    const unsigned int numberPattern = ::pow(3, m_wordsLength);
+    if (counts.size() < numberPattern)
+        counts.resize(numberPattern, 0);
+    usedPatterns.clear();
+
+    unsigned int *wordCounts = counts.data();
+    unsigned int stoppedBucket = 0;
+    const auto countPatterns = [&](const auto &patterns) {
+        if (maxBucket >= size) {
+            patterns.forEach(possibleWords, [&](int, unsigned int pattern) {
+                if (!wordCounts[pattern]++)
+                    usedPatterns.push_back(pattern);
+            });
+        } else {
+            // stopped as soon as a bucket is too big
+            patterns.forEachWhile(possibleWords, [&](int, unsigned int pattern) {
+                if (!wordCounts[pattern])
+                    usedPatterns.push_back(pattern);
+                if (++wordCounts[pattern] <= maxBucket)
+                    return true;
+                stoppedBucket = wordCounts[pattern];
+                return false;
+            });
+        }
+    };
+    // A row is only gathered to read all the answers of the block, reading it for a smaller set
+    // would cost more than reading the matrix.
+    if (gathered != nullptr &&
+        (gathered->isGathered(word) || size == gathered->answers().size())) {
+        d_assert_l(gathered->contains(possibleWords), 20);
+        gathered->visitRow(word, countPatterns);
+    } else {
+        m_patternCache.visitRow(word, countPatterns);
+    }
+
+    double sum = 0;
+    unsigned int largest = 0;
+    for (unsigned int pattern : usedPatterns) {
+        sum += m_nLogN[counts[pattern]];
+        largest = max(largest, counts[pattern]);
+        counts[pattern] = 0;
+    }
+    if (numberPatterns != nullptr)
+        *numberPatterns = usedPatterns.size();
+    if (largestBucket != nullptr)
+        *largestBucket = stoppedBucket ? stoppedBucket : largest;
+    return (m_nLogN[size] - sum) / size;
+}
+
+// Counts the patterns of the rows of a block of words at the possible words. counts has
+// numberPattern buckets per word, the patterns are added to usedPatterns[word] the first time they
+// are counted.
+static void countBlock(const unsigned int *const *rows, const vector<int> &possibleWords,
+                       unsigned int numberPattern, unsigned int *counts,
+                       vector<unsigned int> *usedPatterns) {
+    const unsigned int size = possibleWords.size();
+    for (unsigned int i = 0; i < size; i++) {
+        if (PATTERN_PREFETCH_DISTANCE > 0 && i + PATTERN_PREFETCH_DISTANCE < size) {
+            const int next = possibleWords[i + PATTERN_PREFETCH_DISTANCE];
+            for (unsigned int w = 0; w < SCORED_CANDIDATES_BLOCK; w++) {
+                __builtin_prefetch(rows[w] + next);
+            }
+        }
+        const int answer = possibleWords[i];
+        for (unsigned int w = 0; w < SCORED_CANDIDATES_BLOCK; w++) {
+            const unsigned int pattern = rows[w][answer];
+            if (!counts[w * numberPattern + pattern]++)
+                usedPatterns[w].push_back(pattern);
+        }
+    }
+}
+
+void WordList::countsEntropies(const int *words, unsigned int count,
+                               const vector<int> &possibleWords, const GatheredPatterns *gathered,
+                               double *entropies, unsigned int *largestBuckets) const {
+    // The rows of the words of a block are read at the same answers in one pass: the answers are
+    // read once per block and the scattered reads of the rows are independent, so many more of
+    // them are in flight than with one row at a time. The gathered rows are already dense, they
+    // are read one at a time.
+    const unsigned int size = possibleWords.size();
+    const unsigned int numberPattern = ::pow(3, m_wordsLength);
+    thread_local vector<unsigned int> counts;
+    thread_local vector<unsigned int> usedPatterns[SCORED_CANDIDATES_BLOCK];
+    if (counts.size() < SCORED_CANDIDATES_BLOCK * numberPattern)
+        counts.resize(SCORED_CANDIDATES_BLOCK * numberPattern, 0);
+
+    for (unsigned int start = 0; start < count; start += SCORED_CANDIDATES_BLOCK) {
+        const unsigned int blockSize = min<unsigned int>(SCORED_CANDIDATES_BLOCK, count - start);
+        const int *blockWords = words + start;
+        // same choice of the rows as countsEntropy()
+        const bool isGathered =
+            gathered != nullptr &&
+            (size == gathered->answers().size() ||
+             any_of(blockWords, blockWords + blockSize,
+                    [gathered](int word) { return gathered->isGathered(word); }));
+        if (SCORED_CANDIDATES_BLOCK <= 1 || blockSize <= 1 || size <= 0 || isGathered ||
+            m_patternCache.storage() != PatternStorage::Raw) {
+            for (unsigned int w = 0; w < blockSize; w++) {
+                entropies[start + w] =
+                    countsEntropy(blockWords[w], possibleWords, nullptr, gathered,
+                                  largestBuckets ? largestBuckets + start + w : nullptr);
+            }
+            continue;
+        }
+
+        // the last block is completed with its last word
+        const unsigned int *rows[SCORED_CANDIDATES_BLOCK];
+        for (unsigned int w = 0; w < SCORED_CANDIDATES_BLOCK; w++) {
+            const int word = blockWords[min(w, blockSize - 1)];
+            if (!m_patternCache.isComplete())
+                m_patternCache.waitForRow(word);
+            rows[w] = m_patternCache.rawRow(word).data();
+            usedPatterns[w].clear();
+        }
+        countBlock(rows, possibleWords, numberPattern, counts.data(), usedPatterns);
+
+        // same sum as countsEntropy()
+        for (unsigned int w = 0; w < SCORED_CANDIDATES_BLOCK; w++) {
+            unsigned int *wordCounts = counts.data() + w * numberPattern;
+            double sum = 0;
+            unsigned int largest = 0;
+            for (unsigned int pattern : usedPatterns[w]) {
+                sum += m_nLogN[wordCounts[pattern]];
+                largest = max(largest, wordCounts[pattern]);
+                wordCounts[pattern] = 0;
+            }
+            if (w < blockSize) {
+                entropies[start + w] = (m_nLogN[size] - sum) / size;
+                if (largestBuckets != nullptr)
+                    largestBuckets[start + w] = largest;
+            }
+        }
+    }
+}
+
+vector<double> WordList::entropies(const vector<int> &words, const vector<int> &possibleWords,
+                                   const GatheredPatterns *gathered) const {
+    vector<double> entropies(words.size());
+    if (m_entropyBackend == EntropyBackend::Fast) {
+        countsEntropies(words.data(), words.size(), possibleWords, gathered, entropies.data());
+    } else {
+        for (unsigned int i = 0; i < words.size(); i++) {
+            entropies[i] = weightedEntropy(words[i], possibleWords);
+        }
+    }
+    return entropies;
+}
+
 double WordList::entropy(const vector<int> &possibleWords) const {
+    if (m_entropyBackend == EntropyBackend::Fast) {
+        if (m_scoringParameters.uniformWeights) {
+            const unsigned int size = possibleWords.size();
+            return size ? m_nLogN[size] / size : 0;
+        }
+        thread_local vector<double> weights;
+        weights.resize(possibleWords.size());
+        transform(possibleWords.begin(), possibleWords.end(), weights.begin(),
+                  [this](int word) { return m_words[word].score; });
+        return weightsEntropy(weights);
+    }
+
     const double totalScore = this->totalScore(possibleWords);
     const int size = possibleWords.size();
     double entropy = 0;
@@ -369,39 +853,456 @@ double WordList::entropy(const vector<int> &possibleWords) const {
 
 double WordList::score(int word) const { return score(word, initialCompatibleWords()); }
 
-double WordList::score(int word, const vector<int> &possibleWords) const {
-    const double entropyScore =
-        entropyToScore(entropy(possibleWords) - entropy(word, possibleWords)) + 1;
-    if (entropyScore < 0)
-        cout << getWord(word).word << " - " << entropy(possibleWords) << " - "
-             << entropy(word, possibleWords) << " - " << entropyScore << "\n";
+double WordList::score(int word, const vector<int> &possibleWords,
+                       const GatheredPatterns *gathered) const {
+    return score(word, possibleWords, entropy(possibleWords), totalScore(possibleWords), gathered);
+}
+
+double WordList::score(int word, const vector<int> &possibleWords, double possibilitiesEntropy,
+                       double totalScore, const GatheredPatterns *gathered) const {
+    return evaluate(word, possibleWords, possibilitiesEntropy, totalScore, gathered).score;
+}
+
+vector<Result> WordList::scores(const vector<int> &words, const vector<int> &possibleWords,
+                                const GatheredPatterns *gathered) const {
+    vector<Evaluation> evaluations(words.size());
+    evaluate(words.data(), words.size(), possibleWords, entropy(possibleWords),
+             totalScore(possibleWords), gathered, evaluations.data());
+    vector<Result> results;
+    for (unsigned int i = 0; i < words.size(); i++) {
+        results.push_back({words[i], evaluations[i].score});
+    }
+    return results;
+}
+
+Evaluation WordList::evaluate(int word, const vector<int> &possibleWords,
+                              double possibilitiesEntropy, double totalScore,
+                              const GatheredPatterns *gathered, unsigned int maxBucket) const {
+    // the entropy and the largest bucket come from the same count of the patterns
+    Evaluation evaluation;
+    const double wordEntropy =
+        m_entropyBackend == EntropyBackend::Fast
+            ? countsEntropy(word, possibleWords, nullptr, gathered, &evaluation.largestBucket,
+                            maxBucket)
+            : weightedEntropy(word, possibleWords, &evaluation.largestBucket);
+    if (evaluation.largestBucket > maxBucket) {
+        evaluation.score = INFINITY;
+        return evaluation;
+    }
+    return this->evaluation(word, possibleWords, possibilitiesEntropy, totalScore, wordEntropy,
+                            evaluation.largestBucket);
+}
+
+void WordList::evaluate(const int *words, unsigned int count, const vector<int> &possibleWords,
+                        double possibilitiesEntropy, double totalScore,
+                        const GatheredPatterns *gathered, Evaluation *evaluations) const {
+    if (m_entropyBackend != EntropyBackend::Fast) {
+        for (unsigned int i = 0; i < count; i++) {
+            evaluations[i] =
+                evaluate(words[i], possibleWords, possibilitiesEntropy, totalScore, gathered);
+        }
+        return;
+    }
+
+    double entropies[SCORED_CANDIDATES_BLOCK];
+    unsigned int largestBuckets[SCORED_CANDIDATES_BLOCK];
+    for (unsigned int start = 0; start < count; start += SCORED_CANDIDATES_BLOCK) {
+        const unsigned int blockSize = min<unsigned int>(SCORED_CANDIDATES_BLOCK, count - start);
+        countsEntropies(words + start, blockSize, possibleWords, gathered, entropies,
+                        largestBuckets);
+        for (unsigned int i = 0; i < blockSize; i++) {
+            evaluations[start + i] =
+                evaluation(words[start + i], possibleWords, possibilitiesEntropy, totalScore,
+                           entropies[i], largestBuckets[i]);
+        }
+    }
+}
+
+Evaluation WordList::evaluation(int word, const vector<int> &possibleWords,
+                                double possibilitiesEntropy, double totalScore,
+                                double wordEntropy, unsigned int largestBucket) const {
+    Evaluation evaluation;
+    evaluation.largestBucket = largestBucket;
+    double p = 0;
     if (binary_search(possibleWords.begin(), possibleWords.end(), word)) {
-        const double totalWordScore = totalScore(possibleWords);
-        const double p = getWord(word).score / totalWordScore;
+        p = getWord(word).score / totalScore;
         if (p < 0)
             cout << "p " << getWord(word).word << " - " << p << " - " << getWord(word).score
-                 << " - " << totalWordScore << "\n";
-        return p + (1 - p) * entropyScore;
-    } else {
-        return entropyScore;
+                 << " - " << totalScore << "\n";
     }
+    evaluation.score = m_scoringParameters.score(possibilitiesEntropy, wordEntropy, p);
+    if (evaluation.score < 0)
+        cout << getWord(word).word << " - " << possibilitiesEntropy << " - " << wordEntropy
+             << " - " << evaluation.score << "\n";
+    return evaluation;
+}
+
+// The scores of many words reach the same bound (the score is constant for a low remaining
+// entropy), among them the ones that may split the most the possibilities come first.
+static bool compareBounds(const ScoreBound &a, const ScoreBound &b) {
+    if (a.minScore != b.minScore)
+        return a.minScore < b.minScore;
+    if (a.entropyEstimate != b.entropyEstimate)
+        return a.entropyEstimate > b.entropyEstimate;
+    return a.word < b.word;
+}
+
+// The bounds sorted on demand: a search usually stops after the first candidates, sorting all the
+// bounds would take longer than evaluating them when there are few possibilities.
+class SortedBounds {
+  public:
+    SortedBounds(vector<ScoreBound> &bounds) : m_bounds(bounds), m_sorted(0) {}
+
+    unsigned int size() const { return m_bounds.size(); }
+    const ScoreBound &operator[](unsigned int i) {
+        if (i >= m_sorted) {
+            // the sorted part is doubled
+            const unsigned int end = min<unsigned int>(max({2 * m_sorted, i + 1, 256u}), size());
+            partial_sort(m_bounds.begin() + m_sorted, m_bounds.begin() + end, m_bounds.end(),
+                         &compareBounds);
+            m_sorted = end;
+        }
+        return m_bounds[i];
+    }
+
+  private:
+    vector<ScoreBound> &m_bounds;
+    unsigned int m_sorted;
+};
+
+vector<ScoreBound> WordList::scoreBounds(const vector<int> &possibleWords) const {
+    vector<ScoreBound> bounds =
+        scoreBounds(possibleWords, entropy(possibleWords), totalScore(possibleWords));
+    sort(bounds.begin(), bounds.end(), &compareBounds);
+    return bounds;
+}
+
+vector<ScoreBound> WordList::scoreBounds(const vector<int> &possibleWords,
+                                         double possibilitiesEntropy, double totalScore) const {
+    const int numberLetters = 26;
+    const unsigned int length = m_wordsLength;
+    const unsigned int size = possibleWords.size();
+
+    // The entropy of a word is at most the sum of the entropies of each letter of the pattern.
+    // At a position, the letter is green with a known probability and yellow at most with the
+    // probability that the letter is at another position, which bounds the letter entropy.
+    // [position * numberLetters + letter] = number of possible words with the letter at the
+    // position / at another position.
+    vector<unsigned int> atPosition(length * numberLetters, 0);
+    vector<unsigned int> atOtherPosition(length * numberLetters, 0);
+    bool validLetters = true;
+    for (int w : possibleWords) {
+        const string &word = m_words[w].word;
+        unsigned int letterPositions[numberLetters] = {0};
+        for (unsigned int i = 0; i < length; i++) {
+            const int letter = word[i] - 'A';
+            if (letter < 0 || letter >= numberLetters) {
+                validLetters = false;
+                continue;
+            }
+            letterPositions[letter] |= 1 << i;
+            atPosition[i * numberLetters + letter]++;
+        }
+        for (unsigned int i = 0; i < length; i++) {
+            const int letter = word[i] - 'A';
+            if (letter < 0 || letter >= numberLetters || (letterPositions[letter] & (1 << length)))
+                continue;
+            // each letter of the word is counted once
+            letterPositions[letter] |= 1 << length;
+            for (unsigned int j = 0; j < length; j++) {
+                if (letterPositions[letter] & ~(1 << j) & ((1 << length) - 1))
+                    atOtherPosition[j * numberLetters + letter]++;
+            }
+        }
+    }
+
+    // [position * numberLetters + letter] = bound of the entropy of the letter at the position
+    vector<double> letterEntropies(length * numberLetters);
+    for (unsigned int i = 0; i < length * numberLetters; i++) {
+        const double green = (double)atPosition[i] / size;
+        const double yellow = min((double)atOtherPosition[i] / size, (1 - green) / 2);
+        letterEntropies[i] =
+            entropyTerm(green) + entropyTerm(yellow) + entropyTerm(max(1 - green - yellow, 0.));
+    }
+
+    const double maxEntropy = size > 0 ? log2(size) : 0;
+    const bool isMonotonic = m_scoringParameters.isMonotonic();
+    vector<ScoreBound> bounds;
+    for (int w : m_wordsValids) {
+        ScoreBound bound;
+        bound.word = w;
+        if (!isMonotonic || !validLetters) {
+            bound.minScore = -INFINITY;
+            bound.entropyEstimate = INFINITY;
+            bounds.push_back(bound);
+            continue;
+        }
+
+        const string &word = m_words[w].word;
+        double wordMaxEntropy = 0;
+        for (unsigned int i = 0; i < length; i++) {
+            wordMaxEntropy += letterEntropies[i * numberLetters + word[i] - 'A'];
+        }
+        bound.entropyEstimate = wordMaxEntropy;
+        // the margin covers the rounding errors of the computed entropies
+        wordMaxEntropy = min(wordMaxEntropy, maxEntropy) + 1e-9;
+
+        double p = 0;
+        if (binary_search(possibleWords.begin(), possibleWords.end(), w))
+            p = m_words[w].score / totalScore;
+        bound.minScore = m_scoringParameters.score(possibilitiesEntropy, wordMaxEntropy, p);
+        bounds.push_back(bound);
+    }
+    return bounds;
+}
+
+// Candidates that only differ by letters absent from all the possible words give the same pattern
+// with each possible word (these letters are always gray at any position), so the same score.
+class EquivalentCandidates {
+  public:
+    EquivalentCandidates(const vector<Word> &words, const vector<int> &possibleWords)
+        : m_words(words), m_usedLetters(0), m_validLetters(true) {
+        for (int w : possibleWords) {
+            for (char c : m_words[w].word) {
+                const int letter = c - 'A';
+                if (0 <= letter && letter < 26)
+                    m_usedLetters |= 1 << letter;
+                else
+                    m_validLetters = false;
+            }
+        }
+    }
+
+    // the word where the unused letters are removed, 0 if no other candidate can be equivalent
+    uint64_t signature(int word) const {
+        if (!m_validLetters)
+            return 0;
+        // 5 bits per letter, 0 for an unused letter
+        uint64_t signature = 0;
+        bool hasUnusedLetters = false;
+        for (char c : m_words[word].word) {
+            const int letter = c - 'A';
+            if (letter < 0 || letter >= 26)
+                return 0;
+            const bool isUsed = m_usedLetters & (1 << letter);
+            signature = signature << 5 | (isUsed ? letter + 1 : 0);
+            hasUnusedLetters |= !isUsed;
+        }
+        return hasUnusedLetters ? signature | (uint64_t)1 << 63 : 0;
+    }
+
+  private:
+    const vector<Word> &m_words;
+    uint32_t m_usedLetters;
+    bool m_validLetters;
+};
+
+void WordList::refineOrder(vector<ScoreBound> &bounds, const vector<int> &possibleWords,
+                           const GatheredPatterns *gathered) const {
+    // The entropy is estimated with a few possible words, evenly spaced.
+    const unsigned int size = possibleWords.size();
+    const unsigned int sampleSize = min(size, 24u);
+    vector<int> sample;
+    for (unsigned int i = 0; i < sampleSize; i++) {
+        sample.push_back(possibleWords[(unsigned long)i * size / sampleSize]);
+    }
+
+    for (ScoreBound &bound : bounds) {
+        if (bound.minScore > -INFINITY)
+            bound.entropyEstimate = countsEntropy(bound.word, sample, nullptr, gathered);
+    }
+    sort(bounds.begin(), bounds.end(), &compareBounds);
+}
+
+bool WordList::useSampling(const vector<int> &possibleWords, const Objective &objective) const {
+    // the words are selected by their estimated scores: the largest sets of the other objectives
+    // can't be estimated on a sample
+    const unsigned int minPossibilities = m_samplingParameters.minPossibilities;
+    return objective.type == GuessObjective::Expected && minPossibilities > 0 &&
+           possibleWords.size() >= minPossibilities && m_entropyBackend == EntropyBackend::Fast;
+}
+
+vector<ScoreBound> WordList::sampledCandidates(const vector<int> &possibleWords,
+                                               double possibilitiesEntropy, double totalScore,
+                                               unsigned int number) const {
+    // The entropy of each word is estimated on a random sample of the possibilities, the same
+    // for all the words. All the possibilities have the same weight in the patterns so the
+    // sample is uniform.
+    const unsigned int size = possibleWords.size();
+    const unsigned int numberPatterns = min<unsigned int>(::pow(3, m_wordsLength), size);
+    const unsigned int sampleSize = min(m_samplingParameters.sampleSize(numberPatterns), size);
+
+    vector<int> sample = possibleWords;
+    mt19937 generator(m_samplingParameters.seed ^ size);
+    for (unsigned int i = 0; i < sampleSize; i++) {
+        uniform_int_distribution<unsigned int> distribution(i, size - 1);
+        swap(sample[i], sample[distribution(generator)]);
+    }
+    sample.resize(sampleSize);
+    sort(sample.begin(), sample.end());
+
+    // The words are estimated in the order of their bounds, until no word can be better than
+    // the selected ones.
+    const double maxEntropy = log2(size);
+    vector<ScoreBound> candidates;
+    vector<ScoreBound> bounds = scoreBounds(possibleWords, possibilitiesEntropy, totalScore);
+    SortedBounds sortedBounds(bounds);
+    // only the first of the equivalent candidates is kept
+    const EquivalentCandidates equivalents(m_words, possibleWords);
+    unordered_set<uint64_t> estimatedSignatures;
+    for (unsigned int i = 0; i < sortedBounds.size(); i++) {
+        const ScoreBound &bound = sortedBounds[i];
+        if (candidates.size() >= number && bound.minScore > candidates.back().minScore)
+            break;
+        const uint64_t signature = equivalents.signature(bound.word);
+        if (signature && !estimatedSignatures.insert(signature).second)
+            continue;
+
+        unsigned int usedPatterns;
+        double wordEntropy = countsEntropy(bound.word, sample, &usedPatterns);
+        // Miller-Madow correction of the bias of the estimation
+        wordEntropy += (usedPatterns - 1.) / (2. * sampleSize * log(2.));
+        wordEntropy = min(wordEntropy, maxEntropy);
+
+        double p = 0;
+        if (binary_search(possibleWords.begin(), possibleWords.end(), bound.word))
+            p = m_words[bound.word].score / totalScore;
+
+        ScoreBound candidate;
+        candidate.word = bound.word;
+        // the estimated score, only used to select the words
+        candidate.minScore = m_scoringParameters.score(possibilitiesEntropy, wordEntropy, p);
+        candidate.entropyEstimate = wordEntropy;
+        if (candidates.size() < number || compareBounds(candidate, candidates.back())) {
+            candidates.insert(
+                upper_bound(candidates.begin(), candidates.end(), candidate, &compareBounds),
+                candidate);
+            if (candidates.size() > number)
+                candidates.pop_back();
+        }
+    }
+
+    // the selected words are all evaluated
+    for (ScoreBound &candidate : candidates) {
+        candidate.minScore = -INFINITY;
+    }
+    return candidates;
 }
 
 Result WordList::topWord() const { return topWord(initialCompatibleWords()); }
 
-Result WordList::topWord(std::vector<int> possibleWords) const {
+Result WordList::topWord(std::vector<int> possibleWords, SearchStats *stats) const {
+    return topWord(possibleWords, SearchLimits(), stats);
+}
+
+Result WordList::topWord(const std::vector<int> &possibleWords, const SearchLimits &limits,
+                         SearchStats *stats, const GatheredPatterns *gathered) const {
+    const bool hasDeadline = limits.deadline != chrono::steady_clock::time_point::max();
+    const double possibilitiesEntropy = entropy(possibleWords);
+    const double totalScore = this->totalScore(possibleWords);
+    const bool approximate = useSampling(possibleWords, limits.objective);
+    vector<ScoreBound> bounds;
+    if (approximate) {
+        bounds = sampledCandidates(possibleWords, possibilitiesEntropy, totalScore,
+                                   m_samplingParameters.exactWords);
+    } else {
+        bounds = scoreBounds(possibleWords, possibilitiesEntropy, totalScore);
+        // It doesn't change the number of words evaluated by a full search, but a search stopped
+        // early is more likely to have found the best word.
+        if (hasDeadline || limits.maxEvaluations > 0)
+            refineOrder(bounds, possibleWords, gathered);
+    }
+
+    const Objective &objective = limits.objective;
     Result bestResult;
+    bestResult.word = -1;
     bestResult.score = 10000;
-    double score;
-    const int size = m_wordsValids.size();
-    int w;
-    for (int i = 0; i < size; i++) {
-        w = m_wordsValids[i];
-        if (bestResult.score > (score = this->score(w, possibleWords))) {
-            bestResult.word = w;
-            bestResult.score = score;
+    Evaluation bestEvaluation = {bestResult.score, UINT_MAX};
+    unsigned int evaluated = 0;
+    bool complete = true;
+    // The equivalent candidates have the same bound, the one with the smallest index comes first
+    // and the others can't be chosen.
+    const EquivalentCandidates equivalents(m_words, possibleWords);
+    unordered_set<uint64_t> evaluatedSignatures;
+    // The candidates are sorted by bound, the most promising ones are evaluated first so that the
+    // result is most of the time the final one when the search is stopped by its limits.
+    SortedBounds sortedBounds(bounds);
+    // With the expected objective, the next candidates are evaluated by blocks (see
+    // countsEntropies()), the others stop the count of each candidate with maxBucket() instead.
+    const bool byBlocks = objective.type == GuessObjective::Expected;
+    vector<int> block;
+    Evaluation blockEvaluations[SCORED_CANDIDATES_BLOCK];
+    unsigned int blockPosition = 0;
+    for (unsigned int i = 0; i < sortedBounds.size(); i++) {
+        const ScoreBound &bound = sortedBounds[i];
+        // none of the next candidates can be better (the bounds don't bound the largest buckets)
+        if (objective.type != GuessObjective::WorstCase &&
+            bound.minScore > objective.cost(bestEvaluation))
+            break;
+        const uint64_t signature = equivalents.signature(bound.word);
+        if (signature && !evaluatedSignatures.insert(signature).second)
+            continue;
+        const bool isEvaluated = blockPosition < block.size() && block[blockPosition] == bound.word;
+        if (!isEvaluated && evaluated > 0 &&
+            ((limits.maxEvaluations > 0 && evaluated >= limits.maxEvaluations) ||
+             (hasDeadline && chrono::steady_clock::now() >= limits.deadline))) {
+            complete = false;
+            break;
+        }
+
+        Evaluation evaluation;
+        if (!byBlocks) {
+            // the count of the patterns stops when the candidate can't be as good as the best one
+            evaluation = evaluate(bound.word, possibleWords, possibilitiesEntropy, totalScore,
+                                  gathered, objective.maxBucket(bestEvaluation, bound.minScore));
+            evaluated++;
+        } else {
+            if (!isEvaluated) {
+                // the next candidates the loop would evaluate with the current best word
+                const unsigned int maxSize =
+                    limits.maxEvaluations > 0
+                        ? min<unsigned int>(SCORED_CANDIDATES_BLOCK,
+                                            limits.maxEvaluations - evaluated)
+                        : SCORED_CANDIDATES_BLOCK;
+                block.assign(1, bound.word);
+                vector<uint64_t> blockSignatures;
+                for (unsigned int j = i + 1; j < sortedBounds.size() && block.size() < maxSize;
+                     j++) {
+                    const ScoreBound &next = sortedBounds[j];
+                    if (next.minScore > objective.cost(bestEvaluation))
+                        break;
+                    const uint64_t nextSignature = equivalents.signature(next.word);
+                    if (nextSignature &&
+                        (evaluatedSignatures.count(nextSignature) ||
+                         count(blockSignatures.begin(), blockSignatures.end(), nextSignature)))
+                        continue;
+                    block.push_back(next.word);
+                    blockSignatures.push_back(nextSignature);
+                }
+                evaluate(block.data(), block.size(), possibleWords, possibilitiesEntropy,
+                         totalScore, gathered, blockEvaluations);
+                evaluated += block.size();
+                blockPosition = 0;
+            }
+            evaluation = blockEvaluations[blockPosition++];
+        }
+        // same choice as a scan in the order of the words
+        if (objective.isBetter(evaluation, bestEvaluation) ||
+            (!objective.isBetter(bestEvaluation, evaluation) && bound.word < bestResult.word)) {
+            bestResult.word = bound.word;
+            bestResult.score = evaluation.score;
+            bestEvaluation = evaluation;
+            if (limits.onImprovement)
+                limits.onImprovement(bestResult);
         }
     }
+
+    if (stats != nullptr) {
+        stats->candidates = m_wordsValids.size();
+        stats->evaluated = evaluated;
+        stats->complete = complete;
+        stats->approximate = approximate;
+    }
     return bestResult;
 }
 
@@ -409,38 +1310,109 @@ std::list<Result> WordList::topWords(unsigned int number) const {
     return topWords(initialCompatibleWords(), number);
 }
 
-std::list<Result> WordList::topWords(const std::vector<int> &possibleWords,
-                                     unsigned int number) const {
-    list<Result> topEntropy;
-
-    double score = 0;
-    const int size = m_wordsValids.size();
-    int w;
-    for (int i = 0; i < size; i++) {
-        w = m_wordsValids[i];
-        if (topEntropy.back().score > (score = this->score(w, possibleWords)) ||
-            topEntropy.size() < number) {
-
-            Result result;
-            result.word = w;
-            result.score = score;
-
-            const auto it = lower_bound(topEntropy.begin(), topEntropy.end(), result,
-                                        [](const Result &currentResult, const Result &newResult) {
-                                            return currentResult.score < newResult.score;
-                                        });
+std::list<Result> WordList::topWords(const std::vector<int> &possibleWords, unsigned int number,
+                                     SearchStats *stats, const GatheredPatterns *gathered,
+                                     const Objective &objective) const {
+    const double possibilitiesEntropy = entropy(possibleWords);
+    const double totalScore = this->totalScore(possibleWords);
+    const bool approximate = useSampling(possibleWords, objective);
+    vector<ScoreBound> bounds =
+        approximate ? sampledCandidates(possibleWords, possibilitiesEntropy, totalScore,
+                                        max(number, m_samplingParameters.exactWords))
+                    : scoreBounds(possibleWords, possibilitiesEntropy, totalScore);
+    SortedBounds sortedBounds(bounds);
+
+    struct Candidate {
+        int word;
+        Evaluation evaluation;
+    };
+    list<Candidate> topEntropy;
+    const auto compareCandidates = [&objective](const Candidate &a, const Candidate &b) {
+        return objective.isBetter(a.evaluation, b.evaluation) ||
+               (!objective.isBetter(b.evaluation, a.evaluation) && a.word < b.word);
+    };
+
+    const EquivalentCandidates equivalents(m_words, possibleWords);
+    // [signature] = evaluation of the equivalent candidates
+    unordered_map<uint64_t, Evaluation> equivalentEvaluations;
+    unsigned int evaluated = 0;
+    // the candidates are evaluated by blocks like in topWord()
+    const bool byBlocks = objective.type == GuessObjective::Expected;
+    vector<int> block;
+    Evaluation blockEvaluations[SCORED_CANDIDATES_BLOCK];
+    unsigned int blockPosition = 0;
+    for (unsigned int i = 0; i < sortedBounds.size(); i++) {
+        const ScoreBound &bound = sortedBounds[i];
+        const bool isFull = topEntropy.size() >= number;
+        if (isFull && objective.type != GuessObjective::WorstCase &&
+            bound.minScore > objective.cost(topEntropy.back().evaluation))
+            break;
 
-            topEntropy.insert(it, result);
+        Candidate candidate;
+        candidate.word = bound.word;
+        const uint64_t signature = equivalents.signature(bound.word);
+        const auto it = equivalentEvaluations.find(signature);
+        if (signature && it != equivalentEvaluations.end()) {
+            candidate.evaluation = it->second;
+        } else if (!byBlocks) {
+            // the last candidate only gets better, a candidate stopped now can't be kept later
+            const unsigned int maxBucket =
+                isFull ? objective.maxBucket(topEntropy.back().evaluation, bound.minScore)
+                       : UINT_MAX;
+            candidate.evaluation = evaluate(bound.word, possibleWords, possibilitiesEntropy,
+                                            totalScore, gathered, maxBucket);
+            evaluated++;
+            if (signature)
+                equivalentEvaluations.emplace(signature, candidate.evaluation);
+        } else {
+            if (blockPosition >= block.size() || block[blockPosition] != bound.word) {
+                block.assign(1, bound.word);
+                vector<uint64_t> blockSignatures(1, signature);
+                for (unsigned int j = i + 1;
+                     j < sortedBounds.size() && block.size() < SCORED_CANDIDATES_BLOCK; j++) {
+                    const ScoreBound &next = sortedBounds[j];
+                    if (isFull && next.minScore > objective.cost(topEntropy.back().evaluation))
+                        break;
+                    const uint64_t nextSignature = equivalents.signature(next.word);
+                    if (nextSignature &&
+                        (equivalentEvaluations.count(nextSignature) ||
+                         count(blockSignatures.begin(), blockSignatures.end(), nextSignature)))
+                        continue;
+                    block.push_back(next.word);
+                    blockSignatures.push_back(nextSignature);
+                }
+                evaluate(block.data(), block.size(), possibleWords, possibilitiesEntropy,
+                         totalScore, gathered, blockEvaluations);
+                evaluated += block.size();
+                blockPosition = 0;
+            }
+            candidate.evaluation = blockEvaluations[blockPosition++];
+            if (signature)
+                equivalentEvaluations.emplace(signature, candidate.evaluation);
+        }
+        if (!isFull || compareCandidates(candidate, topEntropy.back())) {
+            const auto it =
+                lower_bound(topEntropy.begin(), topEntropy.end(), candidate, compareCandidates);
+            topEntropy.insert(it, candidate);
             if (topEntropy.size() > number)
                 topEntropy.pop_back();
         }
     }
 
-    return topEntropy;
+    if (stats != nullptr) {
+        stats->candidates = m_wordsValids.size();
+        stats->evaluated = evaluated;
+        stats->approximate = approximate;
+    }
+    list<Result> results;
+    for (const Candidate &candidate : topEntropy) {
+        results.push_back({candidate.word, candidate.evaluation.score});
+    }
+    return results;
 }
 
 bool WordList::isWordCompatible(int word, const Step &step) const {
-    return m_patternCache[word + step.word * m_numberWords] == step.pattern;
+    return m_patternCache.pattern(word, step.word) == step.pattern;
 }
 
 bool WordList::isWordCompatible(int word, const vector<Step> &steps) const {
@@ -450,15 +1422,37 @@ bool WordList::isWordCompatible(int word, const vector<Step> &steps) const {
 
 std::vector<int> WordList::compatibleWords(const std::vector<int> &possibilities,
                                            const Step &step) const {
+    // the row may be loaded long after the first steps of a game
+    if (!m_patternCache.isComplete() && !m_patternCache.isRowReady(step.word))
+        return compatibleWords(possibilities, vector<Step>{step});
+
     std::vector<int> new_possibilities;
-    copy_if(possibilities.begin(), possibilities.end(), back_inserter(new_possibilities),
-            [this, &step](int word) {
-                return m_patternCache[word + step.word * m_numberWords] == step.pattern;
-            });
+    m_patternCache.visitRow(step.word, [&](const auto &patterns) {
+        patterns.forEach(possibilities, [&](int word, unsigned int pattern) {
+            if (pattern == step.pattern)
+                new_possibilities.push_back(word);
+        });
+    });
     return new_possibilities;
 }
 
-std::vector<int> WordList::initialCompatibleWords() const { return m_wordsValids; }
+vector<int> WordList::compatibleWords(const vector<int> &possibilities,
+                                      const vector<Step> &steps) const {
+    WordSet words(m_numberWords, true);
+    for (const Step &step : steps) {
+        words &= m_letterIndex.patternWords(m_words[step.word].word, step.pattern);
+    }
+    return words.filter(possibilities);
+}
+
+std::vector<int> WordList::initialCompatibleWords() const { return m_answersValids; }
+
+std::vector<int> WordList::guessWords() const { return m_wordsValids; }
+
+int WordList::randomAnswer(mt19937_64 &generator) const {
+    d_assert(m_answersValids.size() > 0);
+    return m_answersValids[m_answersTable.sample(generator)];
+}
 
 string WordList::patternToString(const Step &step) const {
     return patternToString(step.word, step.pattern);
@@ -476,15 +1470,126 @@ string WordList::patternToString(int word, int pattern) const {
 }
 
 unsigned int WordList::wordLength() const { return m_wordsLength; }
+const Dictionary &WordList::dictionary() const { return m_dictionary; }
+const ScoringParameters &WordList::scoringParameters() const { return m_scoringParameters; }
+
+void WordList::setScoringParameters(const ScoringParameters &parameters) {
+    m_scoringParameters = parameters;
+    for (Word &word : m_words) {
+        word.score = m_scoringParameters.wordScore(word.frq);
+    }
+    updateAnswersTable();
+}
+
+void WordList::updateAnswersTable() {
+    vector<double> weights;
+    for (int w : m_answersValids) {
+        weights.push_back(m_words[w].score);
+    }
+    m_answersTable = AliasTable(weights);
+}
+
+const SamplingParameters &WordList::samplingParameters() const { return m_samplingParameters; }
+
+void WordList::setSamplingParameters(const SamplingParameters &parameters) {
+    m_samplingParameters = parameters;
+}
+
+const PatternMatrix &WordList::patternMatrix() const { return m_patternCache; }
+
+const LetterIndex &WordList::letterIndex() const { return m_letterIndex; }
+
+bool WordList::canGatherPatterns() const {
+    return (unsigned int)::pow(3, m_wordsLength) <= GatheredPatterns::MAX_PATTERNS;
+}
+
+EntropyBackend WordList::entropyBackend() const { return m_entropyBackend; }
+void WordList::setEntropyBackend(EntropyBackend backend) { m_entropyBackend = backend; }
+
+uint64_t WordList::wordsChecksum() const {
+    // the words in their order, the answers first, and the number of answers
+    string words;
+    for (const Word &word : m_words) {
+        words += word.word + "\n";
+    }
+    return checksum(words.data(), words.size(), m_numberAnswers);
+}
+
+string WordList::settingsKey() const {
+    ostringstream key;
+    key.precision(17);
+    const ScoringParameters &scoring = m_scoringParameters;
+    const SamplingParameters &sampling = m_samplingParameters;
+    key << m_numberWords << " " << m_numberAnswers << " " << m_wordsChecksum << " "
+        << scoring.entropyMul << " " << scoring.entropyOffset << " " << scoring.frequencyMul << " "
+        << scoring.frequencyOffset << " " << scoring.uniformWeights << " "
+        << sampling.minPossibilities << " " << sampling.maxError << " " << sampling.exactWords
+        << " " << sampling.seed << " " << (int)m_entropyBackend;
+    return key.str();
+}
+
+void WordList::loadOpening() {
+    lock_guard<mutex> lock(m_openingMutex);
+    m_openingWord.clear();
+    m_openingKey.clear();
+    if (m_mask.size())
+        return;
+
+    ifstream file(openingPath(m_dictionary));
+    string header;
+    int version;
+    if (!(file >> header >> version) || header != OPENING_FILE_HEADER ||
+        version != OPENING_FILE_VERSION)
+        return;
+    file.ignore(numeric_limits<streamsize>::max(), '\n');
+    string key, word;
+    double score;
+    if (getline(file, key) && file >> word >> score) {
+        m_openingKey = key;
+        m_openingWord = word;
+        m_openingScore = score;
+    }
+}
+
+bool WordList::opening(Result &result) const {
+    lock_guard<mutex> lock(m_openingMutex);
+    if (m_mask.size() || m_openingWord.empty() || m_openingKey != settingsKey() ||
+        !doWordExist(m_openingWord))
+        return false;
+    result.word = getWordIndex(m_openingWord);
+    result.score = m_openingScore;
+    return true;
+}
+
+void WordList::rememberOpening(const Result &result) const {
+    if (m_mask.size())
+        return;
+
+    lock_guard<mutex> lock(m_openingMutex);
+    m_openingKey = settingsKey();
+    m_openingWord = getWord(result.word).word;
+    m_openingScore = result.score;
+    if (!m_saveToCache)
+        return;
+
+    // another process may read it
+    const string temporaryPath = uniqueTemporaryPath(openingPath(m_dictionary));
+    ofstream file(temporaryPath);
+    file.precision(17);
+    file << OPENING_FILE_HEADER << " " << OPENING_FILE_VERSION << "\n"
+         << m_openingKey << "\n"
+         << m_openingWord << " " << m_openingScore << "\n";
+    file.close();
+    if (!file)
+        remove(temporaryPath.c_str());
+    if (!file || !publishFile(temporaryPath, openingPath(m_dictionary)))
+        cerr << "Cannot save the opening in \"" << openingPath(m_dictionary) << "\".\n";
+}
 vector<Word> WordList::words() const { return m_words; }
 
 std::istream &operator>>(std::istream &is, Word &word) {
     is >> word.word >> word.frq;
-#if WORDS_UNIFORM_SCORE
-    word.score = 1;
-#else
-    word.score = tanh(word.frq * WORD_SCORE_MUL + WORD_SCORE_OFFSET) + 1;
-#endif
+    word.score = ScoringParameters().wordScore(word.frq);
     // cout << word.word << "\t" << word.frq << "\t" << word.score << "\n";
     return is;
 };
\ No newline at end of file
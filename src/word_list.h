@@ -1,10 +1,22 @@
 #ifndef SRC_WORD_LIST_H_
 #define SRC_WORD_LIST_H_
 
+#include "alias_table.h"
+#include "entropy.h"
+#include "letter_index.h"
+#include "pattern_matrix.h"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <fstream>
+#include <functional>
 #include <list>
+#include <mutex>
 #include <ostream>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 struct Word {
@@ -15,9 +27,139 @@ struct Word {
 
 std::istream &operator>>(std::istream &is, Word &word);
 
+#define WORDS_UNIFORM_SCORE false
+
+/**
+ * @brief The words of a game, read from data/<name>.txt.
+ *
+ * All the words can be guessed, only some of them are answers: the words of the answers file, or
+ * the words at least as frequent as minAnswerFrequency.
+ */
+struct Dictionary {
+    unsigned int wordLength = 5;
+    // name of the files of the dictionary and of its caches
+    std::string name = "words-5";
+    // file of the answers (one word per line), empty to select them by frequency
+    std::string answersPath;
+    // occurrences per million, 0 for all the words
+    float minAnswerFrequency = 0;
+    // Longer words aren't supported: the signatures of the equivalent candidates hold 5 bits per
+    // letter and the patterns are counted in arrays of 3^length entries on the stack.
+    static constexpr unsigned int MAX_WORD_LENGTH = 12;
+    // the french words have from 4 to MAX_WORD_LENGTH letters
+    static constexpr unsigned int MIN_FRENCH_WORD_LENGTH = 4;
+
+    // the french words of this length, all of them are answers
+    static Dictionary french(unsigned int wordLength);
+    // the english words of 5 letters, the answers are the words with a frequency of at least 1
+    static Dictionary english();
+    // english() for "en", french() of the number of letters otherwise, false for another name
+    static bool fromName(const std::string &name, Dictionary &dictionary);
+};
+
+// The raw pattern matrix is loaded (or generated) by a thread, the words can be used right away.
+#define BACKGROUND_PATTERNS_LOADING true
+
+// The patterns of this number of candidates are counted together against the possibilities (1 to
+// count them one candidate at a time).
+#define SCORED_CANDIDATES_BLOCK 8
+
+struct ScoringParameters {
+    // number of guesses from the entropy remaining: entropyMul * ln(entropy) + entropyOffset
+    double entropyMul = 0.9;
+    double entropyOffset = 1.5;
+    // weight of a word: tanh(frequency * frequencyMul + frequencyOffset) + 1
+    double frequencyMul = 3;
+    double frequencyOffset = -2;
+    // all the words have a weight of 1
+    bool uniformWeights = WORDS_UNIFORM_SCORE;
+
+    double entropyToScore(double entropy) const;
+    double wordScore(float frequency) const;
+    double score(double possibilitiesEntropy, double wordEntropy, double probability) const;
+    // the score never increases with the entropy of the word, needed to bound the scores
+    bool isMonotonic() const;
+};
+
+struct SamplingParameters {
+    // The entropies of the words are estimated on a sample when there are at least this number of
+    // possibilities (0 to never use it), with the expected objective only.
+    unsigned int minPossibilities = 8000;
+    // target error (standard deviation, in bits) of the estimated entropies
+    double maxError = 0.1;
+    // number of words with the best estimated scores whose score is then computed exactly
+    unsigned int exactWords = 32;
+    unsigned int seed = 0;
+
+    unsigned int sampleSize(unsigned int numberPatterns) const;
+};
+
 struct Result {
     int word;
+    // expected number of guesses, whatever the objective
+    double score;
+};
+
+// evaluation of a guess, computed from the sizes of the sets of possibilities it leaves
+struct Evaluation {
     double score;
+    // size of the largest set of possibilities left
+    unsigned int largestBucket;
+};
+
+enum class GuessObjective {
+    // the smallest expected number of guesses (the score)
+    Expected,
+    // the smallest largest set of possibilities left, then the smallest score
+    WorstCase,
+    // the smallest score + worstCaseWeight * log2(largest set of possibilities left)
+    Mixed,
+};
+
+struct Objective {
+    GuessObjective type = GuessObjective::Expected;
+    // at least 0, only used by the Mixed objective
+    double worstCaseWeight = 0.5;
+
+    // a is a better guess than b
+    bool isBetter(const Evaluation &a, const Evaluation &b) const;
+    // the value minimized, with the Expected and Mixed objectives
+    double cost(const Evaluation &evaluation) const;
+    /**
+     * @brief The largest set of possibilities a guess can leave to be as good as the best one.
+     *
+     * @param minScore the score of the guess can't be lower
+     */
+    unsigned int maxBucket(const Evaluation &best, double minScore) const;
+};
+
+struct ScoreBound {
+    int word;
+    // the score of the word can't be lower
+    double minScore;
+    // estimation of the entropy of the word, the words with the same bound are sorted with it
+    double entropyEstimate;
+};
+
+struct SearchLimits {
+    // the best word found so far is returned at this time
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // maximal number of candidates evaluated, 0 for no limit
+    unsigned int maxEvaluations = 0;
+    // called each time a better word is found
+    std::function<void(const Result &)> onImprovement;
+    // what the best word minimizes
+    Objective objective;
+};
+
+struct SearchStats {
+    unsigned int candidates = 0;
+    // candidates whose score has been fully computed
+    unsigned int evaluated = 0;
+    // false if the search has been stopped by its limits
+    bool complete = true;
+    // the candidates were selected with entropies estimated on a sample
+    bool approximate = false;
 };
 
 struct Step {
@@ -25,61 +167,225 @@ struct Step {
     unsigned int pattern;
 };
 
+/**
+ * @brief The words of a dictionary and the patterns of every guess against every answer.
+ *
+ * The answers are the first words (sorted), followed by the words which are only guesses
+ * (sorted). The sets of possibilities only contain answers.
+ */
 class WordList {
   public:
     WordList(unsigned int wordLength, const std::string &mask = "", bool loadFromCache = true,
-             bool saveToCache = true);
+             bool saveToCache = true, PatternStorage storage = DEFAULT_PATTERN_STORAGE);
+    WordList(const Dictionary &dictionary, const std::string &mask = "",
+             bool loadFromCache = true, bool saveToCache = true,
+             PatternStorage storage = DEFAULT_PATTERN_STORAGE);
     ~WordList();
 
     Word getWord(int index) const;
     int getWordIndex(const std::string &word) const;
     bool doWordExist(const std::string &word) const;
     unsigned int numberOfWords() const;
+    // the answers are the words [0, numberOfAnswers())
+    unsigned int numberOfAnswers() const;
+    bool isAnswer(int word) const;
     unsigned int wordLength() const;
+    const Dictionary &dictionary() const;
     std::vector<Word> words() const;
     int getWordPattern(const std::string &word1, const std::string &word2) const;
+    // word1 must be an answer
     int getWordPattern(int word1, int word2) const;
     double totalScore(const std::vector<int> &possibleWords) const;
     double entropy(int word) const;
-    double entropy(int word, const std::vector<int> &possibleWords) const;
+    // gathered: the patterns of the possible words gathered in a block, or nullptr
+    double entropy(int word, const std::vector<int> &possibleWords,
+                   const GatheredPatterns *gathered = nullptr) const;
     double entropy(const std::vector<int> &words) const;
+    // entropy(word, possibleWords) of each word, the patterns of the words are counted by blocks
+    std::vector<double> entropies(const std::vector<int> &words,
+                                  const std::vector<int> &possibleWords,
+                                  const GatheredPatterns *gathered = nullptr) const;
     double score(int word) const;
-    double score(int word, const std::vector<int> &possibleWords) const;
+    double score(int word, const std::vector<int> &possibleWords,
+                 const GatheredPatterns *gathered = nullptr) const;
+    // score(word, possibleWords) of each word, computed like entropies()
+    std::vector<Result> scores(const std::vector<int> &words,
+                               const std::vector<int> &possibleWords,
+                               const GatheredPatterns *gathered = nullptr) const;
     Result topWord() const;
-    Result topWord(std::vector<int> possibleWords) const;
+    Result topWord(std::vector<int> possibleWords, SearchStats *stats = nullptr) const;
+    Result topWord(const std::vector<int> &possibleWords, const SearchLimits &limits,
+                   SearchStats *stats = nullptr, const GatheredPatterns *gathered = nullptr) const;
     std::list<Result> topWords(unsigned int number = 10) const;
-    std::list<Result> topWords(const std::vector<int> &possibleWords,
-                               unsigned int number = 10) const;
+    std::list<Result> topWords(const std::vector<int> &possibleWords, unsigned int number = 10,
+                               SearchStats *stats = nullptr,
+                               const GatheredPatterns *gathered = nullptr,
+                               const Objective &objective = Objective()) const;
+    std::vector<ScoreBound> scoreBounds(const std::vector<int> &possibleWords) const;
     bool isWordCompatible(int word, const Step &step) const;
     bool isWordCompatible(int word, const std::vector<Step> &steps) const;
+    // read from the matrix, or from the letters of the words while the row of the step is loaded
     std::vector<int> compatibleWords(const std::vector<int> &possibilities, const Step &step) const;
+    // the possibilities compatible with all the steps, found from the letters of the words
+    std::vector<int> compatibleWords(const std::vector<int> &possibilities,
+                                     const std::vector<Step> &steps) const;
+    // the answers respecting the mask
     std::vector<int> initialCompatibleWords() const;
+    // the words respecting the mask, which can be guessed
+    std::vector<int> guessWords() const;
+    // a compatible word, drawn with a probability proportional to its score
+    int randomAnswer(std::mt19937_64 &generator) const;
     std::string patternToString(const Step &step) const;
     std::string patternToString(int word, int pattern) const;
+    const ScoringParameters &scoringParameters() const;
+    void setScoringParameters(const ScoringParameters &parameters);
+    const SamplingParameters &samplingParameters() const;
+    void setSamplingParameters(const SamplingParameters &parameters);
+    const PatternMatrix &patternMatrix() const;
+    const LetterIndex &letterIndex() const;
+    // the patterns can be gathered for the possible words (see GatheredPatterns)
+    bool canGatherPatterns() const;
+    EntropyBackend entropyBackend() const;
+    void setEntropyBackend(EntropyBackend backend);
+    // identifies the words and the answers, in their order (the key of the cached matrix)
+    uint64_t wordsChecksum() const;
+    // identifies the words and the parameters the choices depend on (the key of the opening)
+    std::string settingsKey() const;
+
+    /**
+     * @brief The best first guess, saved by rememberOpening() with the same parameters.
+     *
+     * @return false if there is no opening for the current parameters (or with a mask)
+     */
+    bool opening(Result &result) const;
+    // keeps the best first guess, and saves it in the cache unless the word list was built with
+    // saveToCache false, it must have been fully computed
+    void rememberOpening(const Result &result) const;
 
-    void load(unsigned int wordLength, const std::string &mask = "", bool loadFromCache = true,
-              bool saveToCache = true);
+    void load(const Dictionary &dictionary, const std::string &mask = "",
+              bool loadFromCache = true, bool saveToCache = true);
 
   private:
     void cleanMask(const std::string &mask);
     void loadWords();
-    bool loadPatterns();
-    void generatePatterns(bool saveToCache = true);
+    void updateAnswersTable();
+    /**
+     * @brief Opens the cached matrix and checks its header.
+     *
+     * @param bytes receives the number of bytes of a pattern
+     * @param checksums receives the checksum of each row
+     */
+    bool openPatterns(std::ifstream &matrixFile, unsigned int &bytes,
+                      std::vector<uint64_t> &checksums) const;
+    void prepareGeneration();
+    /**
+     * @brief Sets all the rows of the matrix, read from the file if it is open, generated
+     * otherwise.
+     *
+     * The rows waited by other threads are set first with the raw storage. A corrupted row is
+     * generated, then the matrix is saved again. A matrix generated for the cache is always
+     * finished and saved, even if stopLoading() is called.
+     */
+    void fillPatterns(std::ifstream matrixFile, unsigned int bytes,
+                      std::vector<uint64_t> checksums, bool saveToCache);
+    // written in a temporary file, then renamed
+    void savePatterns() const;
+    void stopLoading();
+    void loadOpening();
 
-    bool isWordValid(const Word &word) const;
+    // reads the (sorted) words of the answers file, false if the answers are selected by frequency
+    bool loadAnswers(std::vector<std::string> &answers) const;
+    void updateLetterIndex();
+    /**
+     * @param largestBucket receives the size of the largest bucket, or the size of a bucket bigger
+     * than maxBucket when the count is stopped by it (the entropy is then wrong)
+     */
+    double countsEntropy(int word, const std::vector<int> &possibleWords,
+                         unsigned int *numberPatterns = nullptr,
+                         const GatheredPatterns *gathered = nullptr,
+                         unsigned int *largestBucket = nullptr,
+                         unsigned int maxBucket = UINT_MAX) const;
+    /**
+     * @brief countsEntropy() of count words, the patterns of SCORED_CANDIDATES_BLOCK words are
+     * counted in the same pass over the possible words.
+     *
+     * @param largestBuckets receives the size of the largest bucket of each word, or nullptr
+     */
+    void countsEntropies(const int *words, unsigned int count,
+                         const std::vector<int> &possibleWords, const GatheredPatterns *gathered,
+                         double *entropies, unsigned int *largestBuckets = nullptr) const;
+    double weightedEntropy(int word, const std::vector<int> &possibleWords,
+                           unsigned int *largestBucket = nullptr) const;
+    bool useSampling(const std::vector<int> &possibleWords, const Objective &objective) const;
+    std::vector<ScoreBound> sampledCandidates(const std::vector<int> &possibleWords,
+                                              double possibilitiesEntropy, double totalScore,
+                                              unsigned int number) const;
+    double score(int word, const std::vector<int> &possibleWords, double possibilitiesEntropy,
+                 double totalScore, const GatheredPatterns *gathered) const;
+    /**
+     * @brief The score and the largest bucket of the word, from a single count of the patterns.
+     *
+     * @return a score of INFINITY if the count is stopped by a bucket bigger than maxBucket
+     */
+    Evaluation evaluate(int word, const std::vector<int> &possibleWords,
+                        double possibilitiesEntropy, double totalScore,
+                        const GatheredPatterns *gathered, unsigned int maxBucket = UINT_MAX) const;
+    // evaluate() of count words, whose patterns are counted by countsEntropies()
+    void evaluate(const int *words, unsigned int count, const std::vector<int> &possibleWords,
+                  double possibilitiesEntropy, double totalScore,
+                  const GatheredPatterns *gathered, Evaluation *evaluations) const;
+    // the evaluation of a word from its entropy and its largest bucket
+    Evaluation evaluation(int word, const std::vector<int> &possibleWords,
+                          double possibilitiesEntropy, double totalScore, double wordEntropy,
+                          unsigned int largestBucket) const;
+    // not sorted
+    std::vector<ScoreBound> scoreBounds(const std::vector<int> &possibleWords,
+                                        double possibilitiesEntropy, double totalScore) const;
+    void refineOrder(std::vector<ScoreBound> &bounds, const std::vector<int> &possibleWords,
+                     const GatheredPatterns *gathered) const;
+    Dictionary m_dictionary;
     unsigned int m_wordsLength;
     std::string m_mask;
     std::vector<Word> m_words;
+    // the words respecting the mask
     std::vector<int> m_wordsValids;
+    // the answers respecting the mask, the first ones of m_wordsValids
+    std::vector<int> m_answersValids;
+    // [i] = m_answersValids[i] weighted by the score
+    AliasTable m_answersTable;
     unsigned int m_numberWords;
+    unsigned int m_numberAnswers;
     // matrix of all pattern :
-    // [word1 index + word 2 index * total words] = wordPattern(word1, word2);
-    unsigned int *m_patternCache;
+    // pattern(word1 index, word 2 index) = wordPattern(word1, word2);
+    PatternMatrix m_patternCache;
+    // the words with each letter at each position, to filter them without the matrix
+    LetterIndex m_letterIndex;
+    // descriptor of the lock of the cached matrix, held while it is generated and saved, -1 if
+    // it isn't held (other processes wait for it before reading the cache)
+    int m_patternsLock;
+    // wordsChecksum() of the words
+    uint64_t m_wordsChecksum;
+    // the matrix and the opening are saved in the caches of data/
+    bool m_saveToCache;
+    ScoringParameters m_scoringParameters;
+    SamplingParameters m_samplingParameters;
+    EntropyBackend m_entropyBackend;
+    // [n] = n * log2(n), for n up to the number of words
+    std::vector<double> m_nLogN;
+
+    std::thread m_loadingThread;
+    std::atomic<bool> m_stopLoading;
+    // best first guess and the key of the parameters it was computed with, empty if unknown
+    mutable std::mutex m_openingMutex;
+    mutable std::string m_openingWord;
+    mutable std::string m_openingKey;
+    mutable double m_openingScore;
 };
 
 bool compareWords(const Word &a, const Word &b);
-std::string wordsPath(int wordLength);
-std::string wordsMatrixPath(int wordLength);
+std::string wordsPath(const Dictionary &dictionary);
+std::string wordsMatrixPath(const Dictionary &dictionary);
+std::string openingPath(const Dictionary &dictionary);
 std::string cleanMask(const unsigned int wordLength, const std::string &mask);
 
 #endif // !SRC_WORD_LIST_H_
\ No newline at end of file
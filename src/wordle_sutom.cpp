@@ -0,0 +1,249 @@
+#include "wordle_sutom.h"
+#include "gameResolver.h"
+#include "utils.h"
+#include "word_list.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct ws_dictionary {
+    // kept alive by the sessions
+    shared_ptr<const WordList> wordList;
+    vector<string> words;
+};
+
+struct ws_session {
+    ws_session(const shared_ptr<const WordList> &list) : wordList(list), resolver(*list), mutex() {}
+
+    shared_ptr<const WordList> wordList;
+    GameResolver resolver;
+    std::mutex mutex;
+};
+
+static ws_dictionary *loadDictionary(const Dictionary &words, const char *mask) {
+    try {
+        auto dictionary = make_unique<ws_dictionary>();
+        dictionary->wordList = make_shared<const WordList>(words, mask ? mask : "");
+        // a session needs an answer to draw and to search
+        if (dictionary->wordList->numberOfAnswers() <= 0)
+            return nullptr;
+        for (const Word &word : dictionary->wordList->words()) {
+            dictionary->words.push_back(word.word);
+        }
+        return dictionary.release();
+    } catch (const exception &) {
+        return nullptr;
+    }
+}
+
+ws_dictionary *ws_dictionary_load(unsigned int word_length, const char *mask) {
+    if (word_length < Dictionary::MIN_FRENCH_WORD_LENGTH ||
+        word_length > Dictionary::MAX_WORD_LENGTH)
+        return nullptr;
+    return loadDictionary(Dictionary::french(word_length), mask);
+}
+
+ws_dictionary *ws_dictionary_load_words(const char *name, unsigned int word_length,
+                                        const char *answers_path, double min_answer_frequency,
+                                        const char *mask) {
+    if (!name || word_length <= 0 || word_length > Dictionary::MAX_WORD_LENGTH)
+        return nullptr;
+    // the word list would select the answers by frequency instead
+    if (answers_path && *answers_path && !ifstream(answers_path))
+        return nullptr;
+    Dictionary words;
+    words.wordLength = word_length;
+    words.name = name;
+    words.answersPath = answers_path ? answers_path : "";
+    words.minAnswerFrequency = min_answer_frequency;
+    return loadDictionary(words, mask);
+}
+
+void ws_dictionary_free(ws_dictionary *dictionary) { delete dictionary; }
+
+unsigned int ws_dictionary_word_length(const ws_dictionary *dictionary) {
+    return dictionary ? dictionary->wordList->wordLength() : 0;
+}
+
+unsigned int ws_dictionary_size(const ws_dictionary *dictionary) {
+    return dictionary ? dictionary->words.size() : 0;
+}
+
+unsigned int ws_dictionary_answers_count(const ws_dictionary *dictionary) {
+    return dictionary ? dictionary->wordList->numberOfAnswers() : 0;
+}
+
+const char *ws_dictionary_word(const ws_dictionary *dictionary, int index) {
+    if (!dictionary || index < 0 || index >= (int)dictionary->words.size())
+        return nullptr;
+    return dictionary->words[index].c_str();
+}
+
+int ws_dictionary_word_index(const ws_dictionary *dictionary, const char *word) {
+    if (!dictionary || !word)
+        return -1;
+    string upperWord = word;
+    for_each(upperWord.begin(), upperWord.end(), [](char &c) { c = toupper(c); });
+    return dictionary->wordList->getWordIndex(upperWord);
+}
+
+int ws_dictionary_pattern(const ws_dictionary *dictionary, int answer, int guess) {
+    const int size = ws_dictionary_size(dictionary);
+    if (answer < 0 || answer >= (int)ws_dictionary_answers_count(dictionary) || guess < 0 ||
+        guess >= size)
+        return -1;
+    return dictionary->wordList->getWordPattern(answer, guess);
+}
+
+int ws_parse_pattern(const ws_dictionary *dictionary, const char *pattern) {
+    if (!dictionary || !pattern)
+        return -1;
+    const string input = pattern;
+    if (input.size() != dictionary->wordList->wordLength())
+        return -1;
+
+    int result = 0;
+    for (unsigned int i = 0; i < input.size(); i++) {
+        const char c = input[i];
+        if ('a' <= c && c <= 'z')
+            result += ::pow(3, i);
+        else if ('A' <= c && c <= 'Z')
+            result += 2 * ::pow(3, i);
+        else if (c != '.')
+            return -1;
+    }
+    return result;
+}
+
+ws_session *ws_session_create(const ws_dictionary *dictionary) {
+    if (!dictionary)
+        return nullptr;
+    try {
+        return new ws_session(dictionary->wordList);
+    } catch (const exception &) {
+        return nullptr;
+    }
+}
+
+void ws_session_free(ws_session *session) { delete session; }
+
+void ws_session_reset(ws_session *session) {
+    if (!session)
+        return;
+    lock_guard<mutex> lock(session->mutex);
+    session->resolver.reset();
+}
+
+int ws_session_update(ws_session *session, int word, int pattern) {
+    if (!session || word < 0 || word >= (int)session->wordList->numberOfWords() || pattern < 0 ||
+        pattern >= ::pow(3, session->wordList->wordLength()))
+        return WS_ERROR_ARGUMENT;
+    lock_guard<mutex> lock(session->mutex);
+    try {
+        session->resolver.update(word, pattern);
+    } catch (const exception &) {
+        return WS_ERROR_INTERNAL;
+    }
+    return WS_OK;
+}
+
+int ws_session_set_objective(ws_session *session, int objective, double worst_case_weight) {
+    // a negative weight would favour the guesses leaving big sets (and break the pruning)
+    if (!session || objective < WS_OBJECTIVE_EXPECTED || objective > WS_OBJECTIVE_MIXED ||
+        !(worst_case_weight >= 0))
+        return WS_ERROR_ARGUMENT;
+    Objective sessionObjective;
+    sessionObjective.type = objective == WS_OBJECTIVE_WORST_CASE ? GuessObjective::WorstCase
+                            : objective == WS_OBJECTIVE_MIXED    ? GuessObjective::Mixed
+                                                                 : GuessObjective::Expected;
+    sessionObjective.worstCaseWeight = worst_case_weight;
+    lock_guard<mutex> lock(session->mutex);
+    session->resolver.setObjective(sessionObjective);
+    return WS_OK;
+}
+
+int ws_session_best(ws_session *session, double max_search_time, ws_result *result) {
+    return ws_session_best_with_progress(session, max_search_time, nullptr, nullptr, result);
+}
+
+int ws_session_best_with_progress(ws_session *session, double max_search_time,
+                                  ws_improvement_callback on_improvement, void *user_data,
+                                  ws_result *result) {
+    if (!session || !result)
+        return WS_ERROR_ARGUMENT;
+    lock_guard<mutex> lock(session->mutex);
+    if (session->resolver.possibilitiesCount() <= 0)
+        return WS_ERROR_NO_POSSIBILITY;
+
+    SearchLimits limits;
+    if (max_search_time >= 0)
+        limits.deadline =
+            chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(
+                                              chrono::duration<double>(max_search_time));
+    if (on_improvement)
+        limits.onImprovement = [on_improvement, user_data](const Result &improvement) {
+            const ws_result found = {improvement.word, improvement.score};
+            on_improvement(&found, user_data);
+        };
+    try {
+        const Result best = session->resolver.bestChoice(limits);
+        result->word = best.word;
+        result->score = best.score;
+    } catch (const exception &) {
+        return WS_ERROR_INTERNAL;
+    }
+    return WS_OK;
+}
+
+int ws_session_top(ws_session *session, ws_result *results, unsigned int number) {
+    if (!session || (!results && number > 0))
+        return WS_ERROR_ARGUMENT;
+    lock_guard<mutex> lock(session->mutex);
+    if (session->resolver.possibilitiesCount() <= 0)
+        return WS_ERROR_NO_POSSIBILITY;
+
+    try {
+        int count = 0;
+        for (const Result &choice : session->resolver.topChoices(number)) {
+            results[count].word = choice.word;
+            results[count].score = choice.score;
+            count++;
+        }
+        return count;
+    } catch (const exception &) {
+        return WS_ERROR_INTERNAL;
+    }
+}
+
+unsigned int ws_session_possibilities_count(ws_session *session) {
+    if (!session)
+        return 0;
+    lock_guard<mutex> lock(session->mutex);
+    return session->resolver.possibilitiesCount();
+}
+
+unsigned int ws_session_possibilities(ws_session *session, int *words, unsigned int capacity) {
+    if (!session)
+        return 0;
+    lock_guard<mutex> lock(session->mutex);
+    const vector<int> &possibilities = session->resolver.possibilities();
+    if (words)
+        copy_n(possibilities.begin(), min<size_t>(capacity, possibilities.size()), words);
+    return possibilities.size();
+}
+
+double ws_session_entropy(ws_session *session) {
+    if (!session)
+        return 0;
+    lock_guard<mutex> lock(session->mutex);
+    return session->resolver.entropy();
+}
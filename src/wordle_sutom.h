@@ -0,0 +1,140 @@
+#ifndef SRC_WORDLE_SUTOM_H_
+#define SRC_WORDLE_SUTOM_H_
+
+/**
+ * C API of the solver, built as the shared library wordlesutom.
+ *
+ * A dictionary loads the words and the pattern matrix of a word length (from the data directory of
+ * the working directory), the sessions created from it share its matrix. Each session is a game:
+ * it gets the steps played and gives the best guesses. All the words can be guessed, the answers
+ * are the first ones (all the words of the french dictionaries).
+ *
+ * All the functions can be called from several threads, the calls on the same session are run one
+ * at a time. A pattern is the sum of state * 3^i for each letter i, with state 0 for a letter not
+ * in the answer, 1 for a misplaced letter and 2 for a well placed letter.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define WS_API __declspec(dllexport)
+#else
+#define WS_API __attribute__((visibility("default")))
+#endif
+
+#define WS_OK 0
+// invalid argument (unknown word or pattern, NULL pointer)
+#define WS_ERROR_ARGUMENT -1
+// no word is compatible with the steps played
+#define WS_ERROR_NO_POSSIBILITY -2
+#define WS_ERROR_INTERNAL -3
+
+// what the guesses minimize: the expected number of guesses, the size of the largest set of
+// possibilities left, or the expected number of guesses + weight * log2(largest set left)
+#define WS_OBJECTIVE_EXPECTED 0
+#define WS_OBJECTIVE_WORST_CASE 1
+#define WS_OBJECTIVE_MIXED 2
+
+typedef struct ws_dictionary ws_dictionary;
+typedef struct ws_session ws_session;
+
+typedef struct ws_result {
+    // index of the word in the dictionary
+    int word;
+    // expected number of guesses to find the answer, this one included
+    double score;
+} ws_result;
+
+/**
+ * @brief Loads the french words of this length and their pattern matrix.
+ *
+ * The matrix is loaded in the background, the first searches wait for the rows they read.
+ *
+ * @param mask the letters known (see the program), NULL or "" for none
+ * @return NULL if there is no answer of this length (from 4 to 12 letters)
+ */
+WS_API ws_dictionary *ws_dictionary_load(unsigned int word_length, const char *mask);
+/**
+ * @brief Loads the words of data/<name>.txt, like ws_dictionary_load().
+ *
+ * @param answers_path file of the answers (one word per line), NULL to select them by frequency
+ * @param min_answer_frequency the less frequent words (in occurrences per million) aren't
+ * answers, 0 for all the words
+ * @return NULL if the words have more than 12 letters, if the file of the answers can't be read
+ * or if there is no answer
+ */
+WS_API ws_dictionary *ws_dictionary_load_words(const char *name, unsigned int word_length,
+                                               const char *answers_path,
+                                               double min_answer_frequency, const char *mask);
+// the sessions created from the dictionary can still be used
+WS_API void ws_dictionary_free(ws_dictionary *dictionary);
+WS_API unsigned int ws_dictionary_word_length(const ws_dictionary *dictionary);
+WS_API unsigned int ws_dictionary_size(const ws_dictionary *dictionary);
+// the answers are the words [0, number of answers)
+WS_API unsigned int ws_dictionary_answers_count(const ws_dictionary *dictionary);
+// the word (in upper case), valid until the dictionary is freed, NULL if the index is invalid
+WS_API const char *ws_dictionary_word(const ws_dictionary *dictionary, int index);
+// -1 if the word isn't in the dictionary (the case is ignored)
+WS_API int ws_dictionary_word_index(const ws_dictionary *dictionary, const char *word);
+// the pattern given by the guess when the answer is the other word, -1 if an index is invalid or
+// if the answer isn't one
+WS_API int ws_dictionary_pattern(const ws_dictionary *dictionary, int answer, int guess);
+/**
+ * @brief Reads a pattern written like in the program: '.' for a letter not in the answer, a lower
+ * case letter if it is misplaced and an upper case one if it is well placed.
+ *
+ * @return -1 if it isn't a pattern of the length of the words
+ */
+WS_API int ws_parse_pattern(const ws_dictionary *dictionary, const char *pattern);
+
+WS_API ws_session *ws_session_create(const ws_dictionary *dictionary);
+WS_API void ws_session_free(ws_session *session);
+// forgets the steps played
+WS_API void ws_session_reset(ws_session *session);
+WS_API int ws_session_update(ws_session *session, int word, int pattern);
+// WS_OBJECTIVE_EXPECTED by default, the weight (at least 0) is only used by WS_OBJECTIVE_MIXED
+WS_API int ws_session_set_objective(ws_session *session, int objective, double worst_case_weight);
+/**
+ * @brief The best guess.
+ *
+ * @param max_search_time the best word found is returned after this time (in seconds), no limit
+ * if negative
+ */
+WS_API int ws_session_best(ws_session *session, double max_search_time, ws_result *result);
+// called with each better guess found by a search, and the user data given to the search
+typedef void (*ws_improvement_callback)(const ws_result *result, void *user_data);
+/**
+ * @brief ws_session_best(), which reports the better guesses as they are found.
+ *
+ * @param on_improvement called from the thread of the search, while the session is locked (it
+ * must not use the session), NULL for none; not called if the best guess is known without a
+ * search (the cached opening)
+ */
+WS_API int ws_session_best_with_progress(ws_session *session, double max_search_time,
+                                         ws_improvement_callback on_improvement,
+                                         void *user_data, ws_result *result);
+/**
+ * @brief The best guesses, sorted by score.
+ *
+ * @return the number of results written (at most number), or an error
+ */
+WS_API int ws_session_top(ws_session *session, ws_result *results, unsigned int number);
+WS_API unsigned int ws_session_possibilities_count(ws_session *session);
+/**
+ * @brief The words compatible with the steps played.
+ *
+ * @param words receives the first capacity words
+ * @return the number of possibilities
+ */
+WS_API unsigned int ws_session_possibilities(ws_session *session, int *words,
+                                             unsigned int capacity);
+// entropy of the possibilities (in bits)
+WS_API double ws_session_entropy(ws_session *session);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // !SRC_WORDLE_SUTOM_H_
@@ -0,0 +1,44 @@
+// The dictionaries which can't be loaded are rejected before their words are read.
+#include "../src/word_list.h"
+#include "../src/wordle_sutom.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+using namespace std;
+
+int main() {
+    int failures = 0;
+    const auto check = [&](bool condition, const string &description) {
+        if (!condition) {
+            cerr << "FAILED: " << description << "\n";
+            failures++;
+        }
+    };
+
+    check(ws_dictionary_load(Dictionary::MAX_WORD_LENGTH + 1, nullptr) == nullptr,
+          "ws_dictionary_load of 13 letters");
+    check(ws_dictionary_load(Dictionary::MIN_FRENCH_WORD_LENGTH - 1, nullptr) == nullptr,
+          "ws_dictionary_load of 3 letters");
+    {
+        // the words have the length, they would be loaded
+        const string name = "test-words-13";
+        ofstream("data/" + name + ".txt") << "ABCDEFGHIJKLM 1\nBCDEFGHIJKLMN 1\n";
+        check(ws_dictionary_load_words(name.c_str(), Dictionary::MAX_WORD_LENGTH + 1, nullptr,
+                                       0, nullptr) == nullptr,
+              "ws_dictionary_load_words of 13 letters");
+        remove(("data/" + name + ".txt").c_str());
+    }
+    check(ws_dictionary_load_words("words-5", 0, nullptr, 0, nullptr) == nullptr,
+          "ws_dictionary_load_words of 0 letters");
+
+    Dictionary dictionary;
+    for (const string name : {"13", "3", "abc", "", "5x", "99999999999"}) {
+        check(!Dictionary::fromName(name, dictionary), "Dictionary::fromName(\"" + name + "\")");
+    }
+    check(Dictionary::fromName("12", dictionary) && dictionary.wordLength == 12,
+          "Dictionary::fromName(\"12\")");
+    check(Dictionary::fromName("en", dictionary) && dictionary.name == "en-words-5",
+          "Dictionary::fromName(\"en\")");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,62 @@
+// The searches with the mixed objective choose the same guess as a scan of all the words: the
+// lowest cost, the first word among the ties.
+#include "../src/word_list.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+int main() {
+    WordList wordList(Dictionary::english());
+    const vector<int> answers = wordList.initialCompatibleWords();
+    const vector<int> guesses = wordList.guessWords();
+    const int first = wordList.topWord(answers).word;
+    Objective objective;
+    objective.type = GuessObjective::Mixed;
+
+    // the possibilities left by the best first guess for some answers, SHORT leaves words whose
+    // best guesses have the same cost
+    vector<int> tested = {wordList.getWordIndex("SHORT")};
+    for (unsigned int i = 0; i < answers.size(); i += 50) {
+        tested.push_back(answers[i]);
+    }
+
+    int failures = 0;
+    vector<unsigned int> counts(::pow(3, wordList.wordLength()), 0);
+    for (int answer : tested) {
+        const Step step = {first, (unsigned int)wordList.getWordPattern(answer, first)};
+        const vector<int> possibilities = wordList.compatibleWords(answers, step);
+        if (possibilities.size() < 3)
+            continue;
+
+        int best = -1;
+        double bestCost = INFINITY;
+        for (int guess : guesses) {
+            fill(counts.begin(), counts.end(), 0);
+            unsigned int largestBucket = 0;
+            for (int possibility : possibilities) {
+                largestBucket = max(largestBucket,
+                                    ++counts[wordList.getWordPattern(possibility, guess)]);
+            }
+            const double cost =
+                objective.cost({wordList.score(guess, possibilities), largestBucket});
+            if (cost < bestCost) {
+                best = guess;
+                bestCost = cost;
+            }
+        }
+
+        SearchLimits limits;
+        limits.objective = objective;
+        const Result result = wordList.topWord(possibilities, limits);
+        if (result.word != best) {
+            cerr << "FAILED: " << possibilities.size() << " possibilities after "
+                 << wordList.getWord(answer).word << ", " << wordList.getWord(result.word).word
+                 << " instead of " << wordList.getWord(best).word << "\n";
+            failures++;
+        }
+    }
+    return failures ? 1 : 0;
+}